@@ -0,0 +1,563 @@
+// clang-format off
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#if defined _MSC_VER
+    #include <intrin.h>
+#elif defined __x86_64__ || defined __i386__
+    #include <x86intrin.h>
+#endif
+#include "GroupStats.hpp"
+#include "Histogram.hpp"
+#include "MockTransport.hpp"
+#include "RateAdapter.hpp"
+#include "RecvProcessor.hpp"
+#include "RecvSlot.hpp"
+#include "SampleRing.hpp"
+#include "TimeUtils.hpp"
+#include "Range.hpp"
+// clang-format on
+
+/**
+ * Microbenchmarks of the hot path components shared with swxtch-perf-rio: per group statistics,
+ * header stamping, spin pacing, multicast range expansion, the consumer completion loop and the
+ * whole consumer receive path over MockTransport, with the policies or the virtual calls, and
+ * the latency recording of the hot thread with a sampler taking it every few milliseconds.
+ * Each line gives ns/op and, on x86, TSC cycles/op. RateAdapter checks the convergence of
+ * --adapt_rate over synthetic consumer reports, and the exit code is 1 when a check fails. An
+ * optional argument only runs the benchmarks whose name contains it.
+ *
+ *   rio-bench [filter]
+ */
+
+using namespace riosession;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+constexpr uint32_t MAX_SLOTS = 4096;  // Send ring slots the header benchmarks cycle through
+
+const char* g_Filter = nullptr;
+bool g_Failed = false;  // A check did not hold
+
+inline uint64_t ReadTsc() {
+#if defined _MSC_VER || defined __x86_64__ || defined __i386__
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Keep the compiler from optimizing away a result the benchmark does not use.
+ */
+template <typename T>
+inline void DoNotOptimize(const T& value) {
+#if defined _MSC_VER
+    static volatile const T* sink;
+    sink = &value;
+    _ReadWriteBarrier();
+#else
+    asm volatile("" : : "r,m"(value) : "memory");
+#endif
+}
+
+struct Sample_t {
+    uint64_t Ns = 0;
+    uint64_t Cycles = 0;
+};
+
+/**
+ * @brief Time @p fn, which runs some operations of the benchmark.
+ */
+template <typename Fn>
+inline Sample_t Measure(Fn&& fn) {
+    auto start = Clock::now();
+    uint64_t tsc = ReadTsc();
+    fn();
+    Sample_t sample;
+    sample.Cycles = ReadTsc() - tsc;
+    sample.Ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    return sample;
+}
+
+bool Selected(const std::string& name) {
+    return g_Filter == nullptr || name.find(g_Filter) != std::string::npos;
+}
+
+void Report(const std::string& name, uint64_t ops, const Sample_t& sample) {
+    printf("%-44s %12llu ops %10.2f ns/op %10.2f cycles/op\n", name.c_str(),
+           static_cast<unsigned long long>(ops), static_cast<double>(sample.Ns) / ops,
+           static_cast<double>(sample.Cycles) / ops);
+}
+
+/**
+ * @brief Run @p ops iterations of @p op(i) after a warm up of a tenth of them.
+ */
+template <typename Op>
+void Bench(const std::string& name, uint64_t ops, Op&& op) {
+    if (!Selected(name)) {
+        return;
+    }
+    for (uint64_t i = 0; i < ops / 10; i++) {
+        op(i);
+    }
+    Report(name, ops, Measure([&]() {
+               for (uint64_t i = 0; i < ops; i++) {
+                   op(i);
+               }
+           }));
+}
+
+McGroupStatsMap MakeGroupStats(uint32_t groups) {
+    McGroupStatsMap stats;
+    for (uint32_t g = 0; g < groups; g++) {
+        stats[MakeStreamKey(0xEF000000u + g, 0)];
+    }
+    return stats;
+}
+
+/**
+ * @brief Per packet statistics: map lookup of the stream then sequence accounting.
+ */
+void BenchGroupStatsUpdate() {
+    for (uint32_t groups : {1u, 64u, 1024u}) {
+        auto stats = MakeGroupStats(groups);
+        std::vector<ProtocolHeader_t> headers(groups);
+        for (auto& header : headers) {
+            FillHeader(&header, 0, 0);
+        }
+        Bench("GroupStatsUpdate/" + std::to_string(groups) + " groups", 20000000,
+              [&](uint64_t i) {
+                  uint32_t g = static_cast<uint32_t>(i % groups);
+                  UpdateRxStats(stats[MakeStreamKey(0xEF000000u + g, 0)], 100, &headers[g]);
+                  headers[g].Seq++;
+              });
+    }
+}
+
+/**
+ * @brief Producer header stamping, with and without reading the clock.
+ */
+void BenchHeaderFill() {
+    std::vector<char> slots(MAX_SLOTS * 128);
+    Bench("HeaderFill", 50000000, [&](uint64_t i) {
+        auto pHeader = reinterpret_cast<ProtocolHeader_t*>(&slots[(i % MAX_SLOTS) * 128]);
+        FillHeader(pHeader, i, i);
+    });
+    Bench("get_unix_time", 20000000, [&](uint64_t) { DoNotOptimize(utilities::get_unix_time()); });
+    Bench("HeaderFill+get_unix_time", 20000000, [&](uint64_t i) {
+        auto pHeader = reinterpret_cast<ProtocolHeader_t*>(&slots[(i % MAX_SLOTS) * 128]);
+        FillHeader(pHeader, i, utilities::get_unix_time());
+    });
+}
+
+/**
+ * @brief How far utilities::spin overshoots the requested wait.
+ */
+void BenchSpin() {
+    for (uint64_t requestedNs : {2000ULL, 10000ULL, 100000ULL, 1000000ULL}) {
+        const std::string name = "spin/" + std::to_string(requestedNs) + "ns";
+        if (!Selected(name)) {
+            continue;
+        }
+        const uint64_t ops = std::max<uint64_t>(200000000ULL / requestedNs, 100);
+        uint64_t maxNs = 0;
+        Sample_t total;
+        for (uint64_t i = 0; i < ops; i++) {
+            auto sample = Measure([&]() { utilities::spin(requestedNs); });
+            total.Ns += sample.Ns;
+            total.Cycles += sample.Cycles;
+            maxNs = std::max(maxNs, sample.Ns);
+        }
+        Report(name, ops, total);
+        printf("%-44s %+10.2f%% mean error, %llu ns max\n", "",
+               100.0 * (static_cast<double>(total.Ns) / ops - requestedNs) / requestedNs,
+               static_cast<unsigned long long>(maxNs));
+    }
+}
+
+/**
+ * @brief --mcast_ip parsing: Ipv4Addr_t range creation and expansion.
+ */
+void BenchIpv4Range() {
+    for (const char* range : {"239.5.69.2", "239.5.69.0-255", "239.5.0.0-15.255"}) {
+        size_t addresses = 0;
+        Bench(std::string("Ipv4Range/") + range, 20000, [&](uint64_t) {
+            std::vector<swxtch::net::Ipv4Addr_t> ipVec;
+            for (const auto& ipv4 : swxtch::utils::MakeIpv4Range(range)) {
+                ipVec.push_back(ipv4);
+            }
+            addresses = ipVec.size();
+            DoNotOptimize(ipVec.data());
+        });
+        if (Selected(std::string("Ipv4Range/") + range)) {
+            printf("%-44s %12zu addresses per op\n", "", addresses);
+        }
+    }
+}
+
+/**
+ * @brief RioConsumer::Start per completion work over synthetic RIORESULT batches: slot from
+ * the request context, size check, group address and header from the slot, statistics
+ * update. Reposting is replaced by a counter.
+ */
+void BenchCompletionLoop() {
+    constexpr uint32_t RING = 65536;
+    constexpr uint32_t BATCH = 1000;  // MAX_RIO_RESULTS
+    constexpr uint32_t PASSES = 200;
+    for (uint32_t groups : {1u, 64u, 1024u}) {
+        const std::string name = "CompletionLoop/" + std::to_string(groups) + " groups";
+        if (!Selected(name)) {
+            continue;
+        }
+        RecvSlotLayout_t layout(100);
+        auto ring = std::make_unique<char[]>(static_cast<size_t>(layout.Stride) * RING);
+        auto stats = MakeGroupStats(groups);
+        for (ULONG slot = 0; slot < RING; slot++) {
+            auto addr = layout.Addr(ring.get(), slot);
+            memset(addr, 0, sizeof(*addr));
+            addr->Ipv4.sin_addr.s_addr = 0xEF000000u + slot % groups;
+        }
+        std::vector<RIORESULT> results(BATCH);
+
+        Sample_t total;
+        uint64_t completions = 0;
+        uint64_t reposted = 0;
+        for (uint32_t pass = 0; pass < PASSES; pass++) {
+            // Fresh sequences for every pass, as the NIC would have written them
+            for (ULONG slot = 0; slot < RING; slot++) {
+                auto pHeader = reinterpret_cast<ProtocolHeader_t*>(layout.Data(ring.get(), slot));
+                FillHeader(pHeader, static_cast<uint64_t>(pass) * RING / groups + slot / groups, 0);
+            }
+            for (ULONG first = 0; first + BATCH <= RING; first += BATCH) {
+                for (ULONG i = 0; i < BATCH; i++) {
+                    results[i] = RIORESULT{0, layout.DataSize, 0, first + i};
+                }
+                auto sample = Measure([&]() {
+                    for (ULONG i = 0; i < BATCH; i++) {
+                        auto slot = static_cast<ULONG>(results[i].RequestContext);
+                        if (results[i].BytesTransferred == layout.DataSize) {
+                            auto pHeader = reinterpret_cast<ProtocolHeader_t*>(
+                                layout.Data(ring.get(), slot));
+                            auto addr = layout.Addr(ring.get(), slot);
+                            auto key = MakeStreamKey(addr->Ipv4.sin_addr.s_addr,
+                                                     addr->Ipv4.sin_port);
+                            UpdateRxStats(stats[key], layout.DataSize, pHeader);
+                        }
+                        reposted++;
+                    }
+                });
+                total.Ns += sample.Ns;
+                total.Cycles += sample.Cycles;
+                completions += BATCH;
+            }
+        }
+        DoNotOptimize(reposted);
+        Report(name, completions, total);
+    }
+}
+
+/**
+ * @brief The consumer loop over MockTransport: its packets per second are the ceiling of the
+ *  application logic. The counted loss and reordering must match the injected ones.
+ */
+void BenchMockConsumer() {
+    struct Case_t {
+        uint32_t Groups;
+        double LossPct;
+        double ReorderPct;
+    };
+    for (const auto& c : {Case_t{1, 0, 0}, Case_t{64, 0, 0}, Case_t{64, 1, 1},
+                          Case_t{1024, 0.1, 0.5}}) {
+        char name[64];
+        snprintf(name, sizeof(name), "MockConsumer/%u groups %.1f%% loss %.1f%% reorder",
+                 c.Groups, c.LossPct, c.ReorderPct);
+        if (!Selected(name)) {
+            continue;
+        }
+        MockConfig_t config;
+        config.Groups = c.Groups;
+        config.LossPct = c.LossPct;
+        config.ReorderPct = c.ReorderPct;
+        MockTransport transport(config);
+        StageProfile stages;  // Only filled in builds with RIO_STAGE_PROBES
+        uint64_t tsc = ReadTsc();
+        auto run = RunMockConsumer(transport, std::max<uint64_t>(3200 / c.Groups, 2), &stages);
+        Report(name, run.Completions, Sample_t{run.ElapsedNs, ReadTsc() - tsc});
+        printf("%-44s %10.2f Mpps, drops %llu/%llu, out of order %llu/%llu %s\n", "",
+               run.Completions * 1e3 / run.ElapsedNs,
+               static_cast<unsigned long long>(run.Counted.TotalDrops),
+               static_cast<unsigned long long>(run.Expected.TotalDrops),
+               static_cast<unsigned long long>(run.Counted.TotalOutOfOrder),
+               static_cast<unsigned long long>(run.Expected.TotalOutOfOrder),
+               run.Matches() ? "OK" : "MISMATCH");
+        stages.PrintTotals(name);
+    }
+}
+
+/**
+ * @brief The consumer receive path from 1 to 10,000 groups over MockTransport: packets per
+ *  second as the per stream statistics outgrow the caches, and what grows with the groups. The
+ *  receive ring is one registered pool whatever the group count, split between the sockets;
+ *  only the statistics and the number of sockets grow.
+ */
+void BenchGroupScaling() {
+    constexpr uint64_t PACKETS = 10000000;
+    constexpr uint32_t SOCKET_GROUPS = 256;  // --groups_per_socket default
+    // A std::map node holds three pointers and the color besides the key and the statistics
+    constexpr size_t STATS_NODE_BYTES
+        = sizeof(StreamKey_t) + sizeof(McGroupStats_t) + 4 * sizeof(void*);
+    for (uint32_t groups : {1u, 10u, 100u, 1000u, 10000u}) {
+        const std::string name = "GroupScaling/" + std::to_string(groups) + " groups";
+        if (!Selected(name)) {
+            continue;
+        }
+        MockConfig_t config;
+        config.Groups = groups;
+        config.CyclePerGroup = std::clamp<uint32_t>((1u << 20) / groups, 64, MOCK_CYCLE_PER_GROUP);
+        MockTransport transport(config);
+        uint64_t tsc = ReadTsc();
+        auto run = RunMockConsumer(transport,
+                                   std::max<uint64_t>(PACKETS / transport.CycleLength(), 2));
+        Report(name, run.Completions, Sample_t{run.ElapsedNs, ReadTsc() - tsc});
+        printf("%-44s %10.2f Mpps, stats %9.1f KB, %3u sockets %s\n", "",
+               run.Completions * 1e3 / run.ElapsedNs, groups * STATS_NODE_BYTES / 1024.0,
+               (groups + SOCKET_GROUPS - 1) / SOCKET_GROUPS, run.Matches() ? "OK" : "MISMATCH");
+    }
+}
+
+/**
+ * @brief The receive path as it was before the session policies: statistics through a virtual
+ *  GroupStatsUpdate and the transport behind an interface, one indirect call or two per packet.
+ */
+class VirtualRecvSession {
+   public:
+    virtual ~VirtualRecvSession() = default;
+    virtual ULONG Dequeue(RIORESULT* results, ULONG maxResults) = 0;
+    virtual void PostRecv(ULONG slot) = 0;
+    virtual void GroupStatsUpdate(const SOCKADDR_INET* addr,
+                                  const size_t pktSize,
+                                  const ProtocolHeader_t* pHdr)
+        = 0;
+};
+
+class VirtualMockSession : public VirtualRecvSession {
+   public:
+    explicit VirtualMockSession(MockTransport& transport) : m_Transport(transport) {
+    }
+    ULONG Dequeue(RIORESULT* results, ULONG maxResults) override {
+        return m_Transport.Dequeue(results, maxResults);
+    }
+    void PostRecv(ULONG slot) override {
+        m_Transport.PostRecv(slot);
+    }
+    void GroupStatsUpdate(const SOCKADDR_INET* addr,
+                          const size_t pktSize,
+                          const ProtocolHeader_t* pHdr) override {
+        auto key = MakeStreamKey(addr->Ipv4.sin_addr.s_addr, addr->Ipv4.sin_port);
+        UpdateRxStats(m_GroupStats[key], pktSize, pHdr);
+    }
+
+   private:
+    MockTransport& m_Transport;
+    McGroupStatsMap m_GroupStats;
+};
+
+void RunVirtual(VirtualRecvSession* session, const MockTransport& transport, uint64_t packets) {
+    const RecvSlotLayout_t& layout = transport.Slot();
+    RIORESULT results[MAX_RIO_RESULTS];
+    uint64_t completions = 0;
+    while (completions < packets) {
+        ULONG numResults = session->Dequeue(results, MAX_RIO_RESULTS);
+        for (ULONG i = 0; i < numResults; i++) {
+            auto slot = static_cast<ULONG>(results[i].RequestContext);
+            if (results[i].BytesTransferred == layout.DataSize) {
+                session->GroupStatsUpdate(
+                    layout.Addr(transport.Ring(), slot), layout.DataSize,
+                    reinterpret_cast<ProtocolHeader_t*>(layout.Data(transport.Ring(), slot)));
+            }
+            session->PostRecv(slot);
+        }
+        completions += numResults;
+    }
+}
+
+void RunTemplated(MockTransport& transport, uint64_t packets) {
+    McGroupStatsMap groupStats = MockGroupStats(transport.Config());
+    RcuValue<StreamTable> streams{StreamTable(groupStats)};
+    RecvProcessor<> processor(transport.Slot(), transport.Ring(), &streams, nullptr);
+    RIORESULT results[MAX_RIO_RESULTS];
+    uint64_t completions = 0;
+    while (completions < packets) {
+        ULONG numResults = transport.Dequeue(results, MAX_RIO_RESULTS);
+        processor.Process(results, numResults, 0,
+                          [&transport](const RIORESULT& result) {
+                              transport.Repost(result.RequestContext);
+                          });
+        completions += numResults;
+    }
+}
+
+/**
+ * @brief Per packet cost of the receive path with virtual calls and with compile-time policies,
+ *  over the same MockTransport traffic.
+ */
+void BenchDispatch() {
+    constexpr uint64_t PACKETS = 20000000;
+    for (uint32_t groups : {1u, 64u}) {
+        const std::string suffix = "/" + std::to_string(groups) + " groups";
+        if (!Selected("Dispatch/virtual" + suffix) && !Selected("Dispatch/template" + suffix)) {
+            continue;
+        }
+        MockConfig_t config;
+        config.Groups = groups;
+        Sample_t samples[2];
+        for (int templated = 0; templated < 2; templated++) {
+            MockTransport transport(config);
+            for (ULONG slot = 0; slot < config.RingSize; slot++) {
+                transport.PostRecv(slot);
+            }
+            // Hide the dynamic type so the virtual calls stay virtual
+            VirtualMockSession virtualSession(transport);
+            VirtualRecvSession* volatile laundered = &virtualSession;
+            VirtualRecvSession* session = laundered;
+            samples[templated] = Measure([&]() {
+                if (templated) {
+                    RunTemplated(transport, PACKETS);
+                } else {
+                    RunVirtual(session, transport, PACKETS);
+                }
+            });
+            Report((templated ? "Dispatch/template" : "Dispatch/virtual") + suffix, PACKETS,
+                   samples[templated]);
+        }
+        printf("%-44s %+10.2f ns/op %+10.2f cycles/op with the policies\n", "",
+               (static_cast<double>(samples[1].Ns) - samples[0].Ns) / PACKETS,
+               (static_cast<double>(samples[1].Cycles) - samples[0].Cycles) / PACKETS);
+    }
+}
+
+/**
+ * @brief Latency recording of the consumer hot thread: straight into a histogram, and through
+ *  the IntervalHistogram handshake while a sampler thread takes it every 10ms and pushes
+ *  samples to the SpscRing, as with --latency --report_ms 10. Every recorded value must end up
+ *  in exactly one interval.
+ */
+void BenchIntervalLatency() {
+    constexpr uint64_t BATCH = 1000;  // MAX_RIO_RESULTS
+    constexpr uint64_t BATCHES = 20000;
+    if (Selected("IntervalLatency/plain")) {
+        LatencyHistogram latency;
+        Bench("IntervalLatency/plain", BATCHES * BATCH,
+              [&](uint64_t i) { latency.Record(1000 + (i & 0xffff)); });
+        DoNotOptimize(latency);
+    }
+    const std::string name = "IntervalLatency/handshake, 10ms sampler";
+    if (!Selected(name)) {
+        return;
+    }
+    IntervalHistogram interval;
+    SpscRing<uint64_t, 1024> samples;
+    std::atomic_bool done = false;
+    LatencyHistogram merged;
+    std::thread sampler([&]() {
+        while (!done.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            auto latency = interval.Take();
+            merged.Merge(latency);
+            samples.TryPush(latency.Count());
+        }
+    });
+    auto sample = Measure([&]() {
+        for (uint64_t batch = 0; batch < BATCHES; batch++) {
+            auto& latency = interval.BeginBatch();
+            for (uint64_t i = 0; i < BATCH; i++) {
+                latency.Record(1000 + ((batch * BATCH + i) & 0xffff));
+            }
+            interval.EndBatch();
+        }
+    });
+    done = true;
+    sampler.join();
+    merged.Merge(interval.Take());
+    Report(name, BATCHES * BATCH, sample);
+    uint64_t intervals = 0;
+    uint64_t count;
+    while (samples.TryPop(count)) {
+        intervals++;
+    }
+    printf("%-44s %10llu intervals, %llu/%llu values %s\n", "",
+           static_cast<unsigned long long>(intervals),
+           static_cast<unsigned long long>(merged.Count()),
+           static_cast<unsigned long long>(BATCHES * BATCH),
+           merged.Count() == BATCHES * BATCH ? "OK" : "MISMATCH");
+}
+
+/**
+ * @brief Drive RateAdapter as the producer does with 16 streams between 1K and 1M pps in all,
+ *  against receivers that lose 1% of the packets above a capacity and none below it. It must
+ *  converge within twice the judged periods of a geometric bisection of the range (one
+ *  settling period before each), to a rate within ADAPT_RESOLUTION below the capacity.
+ */
+void BenchRateAdapter() {
+    if (!Selected("RateAdapter")) {
+        return;
+    }
+    constexpr int64_t STREAMS = 16;
+    constexpr int64_t MIN_RATE = 1000 / STREAMS;
+    constexpr int64_t MAX_RATE = 1000000 / STREAMS;
+    const int bound = 2
+                      * static_cast<int>(ceil(log2(log(static_cast<double>(MAX_RATE) / MIN_RATE)
+                                                   / log(1 + ADAPT_RESOLUTION))));
+    for (int64_t capacity : {MIN_RATE, int64_t{100}, int64_t{1000}, int64_t{4321}, int64_t{20000},
+                             int64_t{50000}, MAX_RATE}) {
+        RateAdapter adapter(0.01, MIN_RATE, MAX_RATE);  // The default --adapt_loss_pct
+        int periods = 0;
+        while (!adapter.Converged() && periods < 10 * bound) {
+            const int64_t rate = adapter.Rate();
+            MergedPeriod_t merged;
+            ReceiverPeriod_t receiver;
+            receiver.Counters.Packets = static_cast<uint64_t>(rate * STREAMS);
+            receiver.LossPct = rate > capacity ? 1.0 : 0.0;
+            merged.Receivers.push_back(receiver);
+            adapter.Step(merged, static_cast<double>(rate));
+            periods++;
+        }
+        const int64_t good = adapter.Good();
+        const bool converged = adapter.Converged() && good <= capacity
+                               && good >= capacity / (1 + ADAPT_RESOLUTION);
+        const bool ok = converged && periods <= bound;
+        g_Failed = g_Failed || !ok;
+        printf("%-44s %12lld pps %5d periods (bound %d), rate %lld %s\n", "RateAdapter/converge",
+               static_cast<long long>(capacity * STREAMS), periods, bound,
+               static_cast<long long>(good * STREAMS), ok ? "OK" : (converged ? "SLOW" : "WRONG"));
+    }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        g_Filter = argv[1];
+    }
+    BenchGroupStatsUpdate();
+    BenchHeaderFill();
+    BenchSpin();
+    BenchIpv4Range();
+    BenchCompletionLoop();
+    BenchMockConsumer();
+    BenchGroupScaling();
+    BenchDispatch();
+    BenchIntervalLatency();
+    BenchRateAdapter();
+    return g_Failed ? 1 : 0;
+}
@@ -0,0 +1,36 @@
+#include "ChurnTest.hpp"
+#include "LoopbackRunner.hpp"
+
+namespace riosession {
+
+bool ChurnTest::Start() {
+    args_t producerArgs = *m_Args;
+    producerArgs.PktsToCount = 0;
+    producerArgs.SecondsToRun = m_Args->SecondsToRun ? m_Args->SecondsToRun : CHURN_TEST_SEC;
+    producerArgs.ChurnRate = CHURN_RATE_OFF;
+
+    args_t consumerArgs = *m_Args;
+    consumerArgs.ExpectedPacketRate
+        = static_cast<uint64_t>(m_Args->PacketRate) * m_Args->Streams();
+    consumerArgs.ChurnRate = m_Args->ChurnRate ? m_Args->ChurnRate : CHURN_TEST_RATE;
+
+    auto result = LoopbackRunner(m_ExitSignal).Run(producerArgs, consumerArgs);
+
+    const ChurnReport_t& churn = result.Churn;
+    const bool passed = churn.Joins > 0 && churn.Failed == 0 && churn.NoFirstPacket == 0
+                        && churn.ExistingLost == 0;
+    printf("\nChurn test: %zu churned and %zu existing groups x %zu ports, %d pps per stream, "
+           "%d operations per second, %.1f s\n",
+           churn.ChurnedGroups, churn.ExistingGroups, m_Args->McastPorts.size(),
+           m_Args->PacketRate, consumerArgs.ChurnRate, result.SendMs / 1000.0);
+    printf("\tJoins: %llu (%llu failed calls), without a first packet: %llu, join call p99 "
+           "%.1f us, first packet p99 %.3f ms\n",
+           churn.Joins, churn.Failed, churn.NoFirstPacket,
+           churn.JoinCall.Percentile(99) / 1e3,
+           std::max(churn.FirstPacket.Percentile(99), churn.RejoinPacket.Percentile(99)) / 1e6);
+    printf("\tExisting groups lost %llu packets\n", churn.ExistingLost);
+    printf("Churn test %s\n", passed ? "PASSED" : "FAILED");
+    return passed;
+}
+
+}  // namespace riosession
@@ -0,0 +1,30 @@
+#pragma once
+// clang-format off
+#include <signal.h>
+#include "args.hpp"
+// clang-format on
+
+namespace riosession {
+
+/**
+ * @brief Subscription churn on loopback: a producer sends --pps to every stream of --mcast_ip
+ * for --seconds (CHURN_TEST_SEC if 0) to a consumer in this process (see LoopbackRunner),
+ * which joins and leaves the churned groups at --churn_rate (CHURN_TEST_RATE if 0) operations
+ * per second, see GroupChurn. The consumer prints the join, leave and first packet times.
+ */
+class ChurnTest {
+   public:
+    ChurnTest(args_t* args, volatile sig_atomic_t* signal) : m_Args(args), m_ExitSignal(signal) {
+    }
+    /**
+     * @return bool true when every join got its first packet and the existing groups lost
+     *  nothing
+     */
+    bool Start();
+
+   private:
+    args_t* m_Args;
+    volatile sig_atomic_t* m_ExitSignal;
+};
+
+}  // namespace riosession
@@ -0,0 +1,214 @@
+#include "ControlChannel.hpp"
+// clang-format off
+#include <algorithm>
+#include <iostream>
+#include "StringUtils.hpp"
+#include "Utilities.hpp"
+// clang-format on
+
+namespace riosession {
+
+void StartConsoleControl(std::shared_ptr<ControlQueue> queue) {
+    std::thread([queue]() {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            queue->Push(ControlRequest_t{line, [](const std::string& reply) {
+                                             std::cout << reply << std::endl;
+                                         }});
+        }
+    }).detach();
+}
+
+static sockaddr_in ControlAddress(uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, CONTROL_ADDRESS, &addr.sin_addr.s_addr) != 1) {
+        utilities::ErrorExit("Error converting the control address");
+    }
+    return addr;
+}
+
+/**
+ * @brief Take the next line out of @p pending, without its end of line.
+ *
+ * @return bool false while @p pending holds no complete line
+ */
+static bool NextLine(std::string& pending, std::string& line) {
+    const auto end = pending.find('\n');
+    if (end == std::string::npos) {
+        return false;
+    }
+    line = pending.substr(0, end);
+    pending.erase(0, end + 1);
+    if (!line.empty() && line.back() == '\r') {
+        line.pop_back();
+    }
+    return true;
+}
+
+void SocketControl::Start(std::shared_ptr<ControlQueue> queue, uint16_t port) {
+    m_Listen = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (m_Listen == INVALID_SOCKET) {
+        utilities::ErrorExit("Error opening the control socket");
+    }
+    sockaddr_in addr = ControlAddress(port);
+    if (SOCKET_ERROR == ::bind(m_Listen, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) {
+        utilities::ErrorExit("Error binding the control socket");
+    }
+    if (SOCKET_ERROR == ::listen(m_Listen, SOMAXCONN)) {
+        utilities::ErrorExit("Error listening on the control socket");
+    }
+    m_AcceptThread = std::thread(&SocketControl::AcceptWorker, this, m_Listen, queue);
+}
+
+void SocketControl::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (m_Listen == INVALID_SOCKET) {
+            return;
+        }
+        m_Stopping = true;
+        // Wakes the accept thread up, and the readers through their shutdown
+        ::closesocket(m_Listen);
+        m_Listen = INVALID_SOCKET;
+        for (const auto& connection : m_Connections) {
+            ::shutdown(connection->Socket, SD_BOTH);
+        }
+    }
+    m_AcceptThread.join();
+    for (auto& thread : m_ReadThreads) {
+        thread.join();
+    }
+    m_ReadThreads.clear();
+    m_FinishedReaders.clear();
+    m_Connections.clear();
+}
+
+void SocketControl::AcceptWorker(SOCKET listenSocket, std::shared_ptr<ControlQueue> queue) {
+    while (true) {
+        SOCKET client = ::accept(listenSocket, nullptr, nullptr);
+        std::lock_guard<std::mutex> lock(m_Lock);
+        if (m_Stopping) {
+            if (client != INVALID_SOCKET) {
+                ::closesocket(client);
+            }
+            return;
+        }
+        if (client == INVALID_SOCKET) {
+            continue;  // The client gave up before being accepted
+        }
+        JoinFinishedReaders();
+        auto connection = std::make_shared<Connection_t>(client);
+        m_Connections.push_back(connection);
+        m_ReadThreads.emplace_back(&SocketControl::ReadWorker, this, connection, queue);
+    }
+}
+
+/**
+ * @brief Join the readers of the clients gone since the previous accept. Under m_Lock.
+ */
+void SocketControl::JoinFinishedReaders() {
+    for (const auto id : m_FinishedReaders) {
+        auto reader = std::find_if(
+            m_ReadThreads.begin(), m_ReadThreads.end(),
+            [id](const std::thread& thread) { return thread.get_id() == id; });
+        reader->join();
+        m_ReadThreads.erase(reader);
+    }
+    m_FinishedReaders.clear();
+}
+
+/**
+ * @brief Queue the requests of a client until it disconnects or sends a line longer than
+ *  CONTROL_LINE_MAX. Then forget the connection: its socket closes once the replies still
+ *  queued for it are sent, and the thread is joined on the next accept.
+ */
+void SocketControl::ReadWorker(std::shared_ptr<Connection_t> connection,
+                               std::shared_ptr<ControlQueue> queue) {
+    char buffer[1024];
+    std::string pending;
+    std::string line;
+    while (pending.size() <= CONTROL_LINE_MAX) {
+        const int received = ::recv(connection->Socket, buffer, sizeof(buffer), 0);
+        if (received <= 0) {
+            break;
+        }
+        pending.append(buffer, received);
+        while (NextLine(pending, line)) {
+            if (swxtch::str::trim(line).empty()) {
+                continue;  // Would get no reply
+            }
+            queue->Push(ControlRequest_t{line, [connection](const std::string& reply) {
+                                             connection->Send(reply + "\n\n");
+                                         }});
+        }
+    }
+    std::lock_guard<std::mutex> lock(m_Lock);
+    m_Connections.erase(std::remove(m_Connections.begin(), m_Connections.end(), connection),
+                        m_Connections.end());
+    m_FinishedReaders.push_back(std::this_thread::get_id());
+}
+
+/**
+ * @brief Send all of @p text, or as much as the client takes before it disconnects.
+ */
+void SocketControl::Connection_t::Send(const std::string& text) {
+    std::lock_guard<std::mutex> lock(SendLock);
+    size_t sent = 0;
+    while (sent < text.size()) {
+        const int result
+            = ::send(Socket, text.data() + sent, static_cast<int>(text.size() - sent), 0);
+        if (result <= 0) {
+            return;
+        }
+        sent += result;
+    }
+}
+
+int RunControlClient(uint16_t port) {
+    SOCKET server = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (server == INVALID_SOCKET) {
+        utilities::ErrorExit("Error opening the control socket");
+    }
+    sockaddr_in addr = ControlAddress(port);
+    if (SOCKET_ERROR == ::connect(server, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) {
+        std::cout << "Error: no session takes requests on " << CONTROL_ADDRESS << ":" << port
+                  << std::endl;
+        ::closesocket(server);
+        return 1;
+    }
+    char buffer[1024];
+    std::string pending;
+    std::string request;
+    std::string line;
+    while (std::getline(std::cin, request)) {
+        if (swxtch::str::trim(request).empty()) {
+            continue;
+        }
+        request += "\n";
+        if (SOCKET_ERROR == ::send(server, request.data(), static_cast<int>(request.size()), 0)) {
+            break;
+        }
+        // The reply ends with an empty line
+        while (true) {
+            if (!NextLine(pending, line)) {
+                const int received = ::recv(server, buffer, sizeof(buffer), 0);
+                if (received <= 0) {
+                    std::cout << "Error: the session closed the control connection" << std::endl;
+                    ::closesocket(server);
+                    return 1;
+                }
+                pending.append(buffer, received);
+            } else if (line.empty()) {
+                break;
+            } else {
+                std::cout << line << std::endl;
+            }
+        }
+    }
+    ::closesocket(server);
+    return 0;
+}
+
+}  // namespace riosession
@@ -0,0 +1,123 @@
+#pragma once
+// clang-format off
+#include "stdafx.h"
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+// clang-format on
+
+namespace riosession {
+
+constexpr auto CONTROL_POLL_PERIOD = std::chrono::milliseconds(100);
+constexpr size_t CONTROL_LIST_MAX = 64;  // Groups listed in a reply
+constexpr char CONTROL_ADDRESS[] = "127.0.0.1";  // The control socket is local only
+constexpr size_t CONTROL_LINE_MAX = 4096;  // Longest request line on the control socket
+
+/**
+ * @brief A request line and where its reply goes.
+ */
+struct ControlRequest_t {
+    std::string Line;
+    std::function<void(const std::string&)> Reply;
+};
+
+/**
+ * @brief Requests to a running session, whatever channel they arrive on. The session executes
+ *  them one at a time on its control thread (see RioSession::ControlWorker), never on the hot
+ *  thread. Shared with the channel readers, which may outlive the session.
+ */
+class ControlQueue {
+   public:
+    void Push(ControlRequest_t request) {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Requests.push_back(std::move(request));
+        }
+        m_Ready.notify_one();
+    }
+
+    /**
+     * @return bool false if no request came within @p timeout
+     */
+    bool Pop(ControlRequest_t& request, std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        if (!m_Ready.wait_for(lock, timeout, [this]() { return !m_Requests.empty(); })) {
+            return false;
+        }
+        request = std::move(m_Requests.front());
+        m_Requests.pop_front();
+        return true;
+    }
+
+   private:
+    std::mutex m_Mutex;
+    std::condition_variable m_Ready;
+    std::deque<ControlRequest_t> m_Requests;
+};
+
+/**
+ * @brief Read requests from the console, one per line, and print their replies. The reader
+ *  blocks in std::getline, so its thread is detached and only holds the queue.
+ */
+void StartConsoleControl(std::shared_ptr<ControlQueue> queue);
+
+/**
+ * @brief Take requests on a TCP socket listening on CONTROL_ADDRESS only. A client sends
+ *  requests one per line and gets each reply back as lines of text ended by an empty line;
+ *  several clients may be connected at once, their requests are queued in arrival order.
+ */
+class SocketControl {
+   public:
+    ~SocketControl() {
+        Stop();
+    }
+    void Start(std::shared_ptr<ControlQueue> queue, uint16_t port);
+    /**
+     * @brief Close the listening socket and the connections, and join their threads. Replies
+     *  to requests still queued are dropped.
+     */
+    void Stop();
+
+   private:
+    /**
+     * @brief A client's socket, closed once its reader and its last queued reply are done.
+     */
+    struct Connection_t {
+        SOCKET Socket;
+        std::mutex SendLock;
+        explicit Connection_t(SOCKET socket) : Socket(socket) {
+        }
+        ~Connection_t() {
+            ::closesocket(Socket);
+        }
+        void Send(const std::string& text);
+    };
+
+    void AcceptWorker(SOCKET listenSocket, std::shared_ptr<ControlQueue> queue);
+    void ReadWorker(std::shared_ptr<Connection_t> connection, std::shared_ptr<ControlQueue> queue);
+    void JoinFinishedReaders();
+
+    SOCKET m_Listen = INVALID_SOCKET;
+    std::thread m_AcceptThread;
+    std::mutex m_Lock;  // Connections and their threads, added by the accept thread
+    std::vector<std::shared_ptr<Connection_t>> m_Connections;  // Of the readers still running
+    std::vector<std::thread> m_ReadThreads;
+    std::vector<std::thread::id> m_FinishedReaders;  // Joined on the next accept
+    bool m_Stopping = false;
+};
+
+/**
+ * @brief The control command: send the lines read from the console, one request each, to the
+ *  control socket of a session running on this host and print the replies.
+ *
+ * @return int The exit code, 1 when the session cannot be reached
+ */
+int RunControlClient(uint16_t port);
+
+}  // namespace riosession
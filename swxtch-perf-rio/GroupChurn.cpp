@@ -0,0 +1,192 @@
+#include "GroupChurn.hpp"
+// clang-format off
+#include <algorithm>
+// clang-format on
+
+namespace riosession {
+
+using std::chrono::steady_clock;
+
+static uint64_t ElapsedNs(steady_clock::time_point from, steady_clock::time_point to) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(to - from).count();
+}
+
+GroupChurn::GroupChurn(const args_t& args, McGroupStatsMap& groupStats, Membership_t membership)
+    : m_Args(args),
+      m_Membership(std::move(membership)),
+      m_FirstChurned(args.McastAddrStr.size() - ChurnedGroups(args)) {
+    for (size_t group = 0; group < args.McastAddrStr.size(); group++) {
+        std::vector<Stream_t> streams;
+        for (const auto port : args.McastPorts) {
+            const auto key = MakeStreamKey(args.McastAddrStr[group].ipNetOrder(), htons(port));
+            streams.push_back(Stream_t{key, &groupStats[key]});
+        }
+        if (group < m_FirstChurned) {
+            for (const auto& stream : streams) {
+                m_ExistingStreams.push_back(stream.Stats);
+            }
+        } else {
+            m_ChurnedStreams.push_back(std::move(streams));
+        }
+    }
+    m_Report.ChurnedGroups = m_ChurnedStreams.size();
+    m_Report.ExistingGroups = m_FirstChurned;
+}
+
+size_t GroupChurn::ChurnedGroups(const args_t& args) {
+    if (args.ChurnRate == CHURN_RATE_OFF) {
+        return 0;
+    }
+    const size_t groups = args.McastAddrStr.size();
+    const size_t churned = args.ChurnGroups != CHURN_GROUPS_AUTO ? args.ChurnGroups
+                                                                 : (groups + 1) / 2;
+    return std::min(churned, groups);
+}
+
+void GroupChurn::Start() {
+    m_ExistingDrops = m_ExistingDropsAtStart = ExistingDrops();
+    m_Thread = std::make_unique<std::thread>(&GroupChurn::Worker, this);
+}
+
+/**
+ * @brief Stop the operations. Joins still waiting for their first packet are not counted.
+ */
+void GroupChurn::Stop() {
+    m_Stop = true;
+    if (m_Thread && m_Thread->joinable()) {
+        m_Thread->join();
+    }
+    const uint64_t drops = ExistingDrops();
+    m_Report.ExistingLost = drops - std::min(m_ExistingDropsAtStart, drops);
+}
+
+/**
+ * @brief First join every churned group in --mcast_ip order, then leave and join them again
+ *  round robin: a group is left for one period every 2 x churned groups periods.
+ */
+void GroupChurn::Worker() {
+    const auto period = std::chrono::duration_cast<steady_clock::duration>(
+        std::chrono::duration<double>(1.0 / m_Args.ChurnRate));
+    const size_t churned = m_ChurnedStreams.size();
+    auto due = steady_clock::now();
+    for (size_t i = 0; i < churned && WaitUntil(due); i++, due += period) {
+        ChangeMembership(m_FirstChurned + i, true, true);
+        RecordExistingLoss();
+    }
+    for (uint64_t op = 0; churned != 0 && WaitUntil(due); op++, due += period) {
+        ChangeMembership(m_FirstChurned + (op / 2) % churned, op % 2 == 1, false);
+        RecordExistingLoss();
+    }
+}
+
+/**
+ * @brief Join or leave @p group on the socket of every port, timing each call. A join waits
+ *  for the first packet of each of its streams, a leave gives up on the ones still waiting.
+ */
+void GroupChurn::ChangeMembership(size_t group, bool join, bool first) {
+    const auto& streams = m_ChurnedStreams[group - m_FirstChurned];
+    if (!join) {
+        auto left = std::remove_if(m_Pending.begin(), m_Pending.end(), [&](const Pending_t& p) {
+            return std::any_of(streams.begin(), streams.end(),
+                               [&](const Stream_t& stream) { return stream.Stats == p.Stats; });
+        });
+        m_Report.LeftEarly += m_Pending.end() - left;
+        m_Pending.erase(left, m_Pending.end());
+    }
+    for (size_t port = 0; port < streams.size(); port++) {
+        McGroupStats_t* stats = streams[port].Stats;
+        const uint64_t packets = stats->Packets.load();
+        if (join && !first) {
+            // Published before the hot thread accounts the stream again
+            stats->Rejoined.store(true, std::memory_order_relaxed);
+            stats->Left.store(false, std::memory_order_release);
+        }
+        const auto start = steady_clock::now();
+        const int result = m_Membership(group, port, join);
+        const uint64_t callNs = ElapsedNs(start, steady_clock::now());
+        if (!join && result == 0) {
+            stats->Left.store(true, std::memory_order_release);
+        }
+        if (result != 0) {
+            m_Report.Failed++;
+        } else if (join) {
+            m_Report.Joins++;
+            m_Report.JoinCall.Record(callNs);
+            size_t firstJoin = SIZE_MAX;
+            if (first) {
+                firstJoin = m_Report.FirstJoins.size();
+                m_Report.FirstJoins.push_back(FirstJoin_t{streams[port].Key, callNs, 0});
+            }
+            m_Pending.push_back(Pending_t{stats, start, packets, firstJoin});
+        } else {
+            m_Report.Leaves++;
+            m_Report.LeaveCall.Record(callNs);
+        }
+    }
+}
+
+/**
+ * @brief Wait for @p due while watching the first packets.
+ * @return bool false when stopped
+ */
+bool GroupChurn::WaitUntil(steady_clock::time_point due) {
+    while (!m_Stop.load()) {
+        PollFirstPackets();
+        const auto now = steady_clock::now();
+        if (now >= due) {
+            return true;
+        }
+        if (m_Pending.empty()) {
+            std::this_thread::sleep_for(std::min<steady_clock::duration>(due - now,
+                                                                         CHURN_IDLE_SLEEP));
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    return false;
+}
+
+void GroupChurn::PollFirstPackets() {
+    const auto now = steady_clock::now();
+    for (size_t i = 0; i < m_Pending.size();) {
+        const Pending_t& pending = m_Pending[i];
+        const bool arrived = pending.Stats->Packets.load() != pending.Packets;
+        if (!arrived && now - pending.Joined < CHURN_FIRST_PACKET_TIMEOUT) {
+            i++;
+            continue;
+        }
+        if (arrived) {
+            const uint64_t firstPacketNs = ElapsedNs(pending.Joined, now);
+            if (pending.FirstJoin != SIZE_MAX) {
+                m_Report.FirstPacket.Record(firstPacketNs);
+                m_Report.FirstJoins[pending.FirstJoin].FirstPacketNs = firstPacketNs;
+            } else {
+                m_Report.RejoinPacket.Record(firstPacketNs);
+            }
+        } else {
+            m_Report.NoFirstPacket++;
+        }
+        m_Pending[i] = m_Pending.back();
+        m_Pending.pop_back();
+    }
+}
+
+/**
+ * @brief Record the drops the existing groups gained since the previous operation.
+ */
+void GroupChurn::RecordExistingLoss() {
+    const uint64_t drops = ExistingDrops();
+    // An out of order packet cancels a drop, the sum can go down
+    m_Report.ExistingLoss.Record(drops - std::min(m_ExistingDrops, drops));
+    m_ExistingDrops = drops;
+}
+
+uint64_t GroupChurn::ExistingDrops() const {
+    uint64_t drops = 0;
+    for (const auto stats : m_ExistingStreams) {
+        drops += stats->RxDropped.load();
+    }
+    return drops;
+}
+
+}  // namespace riosession
@@ -0,0 +1,117 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "args.hpp"
+#include "GroupStats.hpp"
+#include "Histogram.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr int CHURN_TEST_RATE = 20;  // churn command, when --churn_rate is 0
+constexpr int CHURN_TEST_SEC = 20;   // churn command, when --seconds is 0
+constexpr auto CHURN_FIRST_PACKET_TIMEOUT = std::chrono::seconds(5);
+constexpr auto CHURN_IDLE_SLEEP = std::chrono::milliseconds(10);  // Longest sleep between polls
+constexpr size_t CHURN_LIST_MAX = 64;  // First joins printed one by one
+
+/**
+ * @brief First join of a churned stream: how long the join call took and how long until its
+ *  first packet, 0 if none came within CHURN_FIRST_PACKET_TIMEOUT.
+ */
+struct FirstJoin_t {
+    StreamKey_t Key = 0;
+    uint64_t JoinCallNs = 0;
+    uint64_t FirstPacketNs = 0;
+};
+
+struct ChurnReport_t {
+    size_t ChurnedGroups = 0;
+    size_t ExistingGroups = 0;
+    uint64_t Joins = 0;
+    uint64_t Leaves = 0;
+    uint64_t Failed = 0;         // Membership calls that returned an error
+    uint64_t NoFirstPacket = 0;  // Joins with no packet within CHURN_FIRST_PACKET_TIMEOUT
+    uint64_t LeftEarly = 0;      // Joins left again before their first packet
+    LatencyHistogram JoinCall;
+    LatencyHistogram LeaveCall;
+    LatencyHistogram FirstPacket;   // First joins, from the join call to the first packet
+    LatencyHistogram RejoinPacket;  // Same for the joins after a leave
+    LatencyHistogram ExistingLoss;  // Packets the existing groups lost, per operation
+    uint64_t ExistingLost = 0;
+    std::vector<FirstJoin_t> FirstJoins;  // In join order
+};
+
+/**
+ * @brief Subscription churn on a running consumer. The last --churn_groups groups of
+ *  --mcast_ip are not joined with the others: they are joined one at a time at --churn_rate
+ *  operations per second, then left and joined again round robin, one operation per period,
+ *  until the consumer stops. Every membership call is timed, and so is the delay from a join
+ *  to the first packet of each of its streams, which is seen as the stream's packet counter
+ *  moving: the counters the hot thread updates anyway, so the receive path is unchanged.
+ *  While a first packet is awaited the thread polls the counters with a yield in between, for
+ *  microsecond resolution; otherwise it sleeps until the next operation. After every operation
+ *  the drops the other, existing, groups gained since the previous one are recorded: the loss
+ *  the churn caused to the traffic already flowing. A left stream is not accounted until it is
+ *  joined again, from its next packet on, so the packets sent in between are not drops and a
+ *  late packet of the previous join is not a first packet.
+ */
+class GroupChurn {
+   public:
+    /**
+     * @brief Join (or leave) @p group, an index in --mcast_ip, on the socket of the port of
+     *  index @p port. Returns the setsockopt result.
+     */
+    using Membership_t = std::function<int(size_t group, size_t port, bool join)>;
+
+    GroupChurn(const args_t& args, McGroupStatsMap& groupStats, Membership_t membership);
+
+    /**
+     * @brief Number of groups churned, the others are joined up front.
+     */
+    static size_t ChurnedGroups(const args_t& args);
+
+    void Start();
+    void Stop();
+    const ChurnReport_t& Report() const {
+        return m_Report;
+    }
+
+   private:
+    struct Stream_t {
+        StreamKey_t Key;
+        McGroupStats_t* Stats;
+    };
+    struct Pending_t {
+        McGroupStats_t* Stats;
+        std::chrono::steady_clock::time_point Joined;
+        uint64_t Packets;  // Before the join
+        size_t FirstJoin;  // Index in FirstJoins, SIZE_MAX for a rejoin
+    };
+
+    void Worker();
+    void ChangeMembership(size_t group, bool join, bool first);
+    bool WaitUntil(std::chrono::steady_clock::time_point due);
+    void PollFirstPackets();
+    void RecordExistingLoss();
+    uint64_t ExistingDrops() const;
+
+    const args_t& m_Args;
+    Membership_t m_Membership;
+    size_t m_FirstChurned;  // Index of the first churned group
+    std::vector<std::vector<Stream_t>> m_ChurnedStreams;  // Per churned group, per port
+    std::vector<McGroupStats_t*> m_ExistingStreams;
+    std::vector<Pending_t> m_Pending;
+    uint64_t m_ExistingDrops = 0;
+    uint64_t m_ExistingDropsAtStart = 0;
+    ChurnReport_t m_Report;
+    std::atomic_bool m_Stop = false;
+    std::unique_ptr<std::thread> m_Thread;
+};
+
+}  // namespace riosession
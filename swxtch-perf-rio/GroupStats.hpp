@@ -0,0 +1,219 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <utility>
+#include <vector>
+// clang-format on
+
+/**
+ * Packet header and per stream (group and port) statistics of the hot path. Free of Windows
+ * dependencies so the benchmarks build on Linux too.
+ */
+namespace riosession {
+
+constexpr uint16_t PROTOCOL_TOKEN = 490u;
+
+#pragma pack(push, 1)
+struct ProtocolHeader_t {
+    uint16_t Token;
+    uint8_t CmdType;
+    uint8_t Tag;
+    uint64_t Seq;
+    uint64_t Timestamp;
+};
+#pragma pack(pop)
+
+/**
+ * @brief Stamp the header of a synthetic packet.
+ */
+inline void FillHeader(ProtocolHeader_t* pHeader, uint64_t seq, uint64_t timestamp) {
+    pHeader->Token = PROTOCOL_TOKEN;
+    pHeader->CmdType = 0;
+    pHeader->Seq = seq;
+    pHeader->Timestamp = timestamp;
+}
+
+struct McGroupStats_t {
+    std::atomic<uint64_t> Packets;
+    std::atomic<uint64_t> Bytes;
+    std::atomic<uint64_t> Sequence;
+    std::atomic<uint64_t> ExpectedSequence;
+    std::atomic<uint64_t> OutOfOrder;
+    std::atomic<uint64_t> RxDropped;
+    std::atomic<bool> Left;      // Left (churn or leave request), what still arrives came before
+    std::atomic<bool> Rejoined;  // Joined again, the next packet resyncs
+
+    McGroupStats_t()
+        : Packets(0),
+          Bytes(0),
+          Sequence(0),
+          ExpectedSequence(0),
+          OutOfOrder(0),
+          RxDropped(0),
+          Left(false),
+          Rejoined(false) {
+    }
+
+    McGroupStats_t(const McGroupStats_t& other) {
+        Packets.store(other.Packets.load());
+        Bytes.store(other.Bytes.load());
+        Sequence.store(other.Sequence.load());
+        ExpectedSequence.store(other.ExpectedSequence.load());
+        OutOfOrder.store(other.OutOfOrder.load());
+        RxDropped.store(other.RxDropped.load());
+        Left.store(other.Left.load());
+        Rejoined.store(other.Rejoined.load());
+    }
+
+    McGroupStats_t& operator=(const McGroupStats_t& other) {
+        Packets.store(other.Packets.load());
+        Bytes.store(other.Bytes.load());
+        Sequence.store(other.Sequence.load());
+        ExpectedSequence.store(other.ExpectedSequence.load());
+        OutOfOrder.store(other.OutOfOrder.load());
+        RxDropped.store(other.RxDropped.load());
+        Left.store(other.Left.load());
+        Rejoined.store(other.Rejoined.load());
+        return *this;
+    }
+};
+
+struct TotalStats_t {
+    uint64_t TotalPackets = 0;
+    uint64_t TotalBytes = 0;
+    uint64_t TotalOutOfOrder = 0;
+    uint64_t TotalDrops = 0;
+};
+
+/**
+ * @brief Statistics are kept per stream, a group and a destination port, both in network order
+ *  as they are in the socket addresses.
+ */
+using StreamKey_t = uint64_t;
+
+inline StreamKey_t MakeStreamKey(uint32_t group, uint16_t port) {
+    return (static_cast<uint64_t>(group) << 16) | port;
+}
+inline uint32_t StreamGroup(StreamKey_t key) {
+    return static_cast<uint32_t>(key >> 16);
+}
+inline uint16_t StreamPort(StreamKey_t key) {
+    return static_cast<uint16_t>(key);
+}
+
+constexpr size_t STAMPED_HEADER_SIZE = sizeof(ProtocolHeader_t) + sizeof(StreamKey_t);
+
+/**
+ * @brief Write the stream of a packet right after its header, for a producer measuring the
+ *  round trip: the echo comes back from the reflector's address, not the group's.
+ */
+inline void StampStream(ProtocolHeader_t* pHeader, StreamKey_t key) {
+    memcpy(pHeader + 1, &key, sizeof(key));
+}
+inline StreamKey_t StampedStream(const ProtocolHeader_t* pHeader) {
+    StreamKey_t key;
+    memcpy(&key, pHeader + 1, sizeof(key));
+    return key;
+}
+
+using McGroupStatsMap = std::map<StreamKey_t, struct McGroupStats_t>;
+
+/**
+ * @brief What the hot thread looks the statistics of a stream up in: the keys of a
+ *  McGroupStatsMap, sorted, next to pointers to their entries, which a map never moves. A
+ *  binary search over one array touches fewer cache lines than walking the map's tree, and
+ *  the table is rebuilt, off the hot thread, when streams are added (see RcuValue).
+ */
+class StreamTable {
+   public:
+    StreamTable() = default;
+    explicit StreamTable(McGroupStatsMap& groupStats) {
+        m_Entries.reserve(groupStats.size());
+        for (auto& [key, stats] : groupStats) {
+            m_Entries.emplace_back(key, &stats);
+        }
+    }
+
+    /**
+     * @return McGroupStats_t* nullptr for a stream that is not in the table
+     */
+    inline McGroupStats_t* Find(StreamKey_t key) const {
+        auto entry = std::lower_bound(
+            m_Entries.begin(), m_Entries.end(), key,
+            [](const std::pair<StreamKey_t, McGroupStats_t*>& e, StreamKey_t k) {
+                return e.first < k;
+            });
+        return entry != m_Entries.end() && entry->first == key ? entry->second : nullptr;
+    }
+
+    size_t Size() const {
+        return m_Entries.size();
+    }
+
+   private:
+    std::vector<std::pair<StreamKey_t, McGroupStats_t*>> m_Entries;
+};
+
+/**
+ * @brief Snapshot of the statistics of every group added up.
+ */
+inline TotalStats_t SumStats(const McGroupStatsMap& groupStats) {
+    TotalStats_t totals;
+    for (auto const& [key, value] : groupStats) {
+        totals.TotalPackets += value.Packets.load();
+        totals.TotalBytes += value.Bytes.load();
+        totals.TotalOutOfOrder += value.OutOfOrder.load();
+        totals.TotalDrops += value.RxDropped.load();
+    }
+    return totals;
+}
+
+/**
+ * @brief Account a received packet in its group statistics: sequence gaps are drops, older
+ *  sequences are out of order packets (and cancel a drop counted earlier). A stream left is
+ *  not accounted, and when joined again its sequence starts over from the next packet:
+ *  what was sent in between was not subscribed to.
+ */
+inline void UpdateRxStats(McGroupStats_t& gmc, const size_t pktSize, const ProtocolHeader_t* pHdr) {
+    if (gmc.Left.load(std::memory_order_acquire)) {
+        return;
+    }
+    if (gmc.Rejoined.load(std::memory_order_relaxed)) {
+        gmc.Rejoined.store(false, std::memory_order_relaxed);
+        gmc.ExpectedSequence.store(pHdr->Seq);
+    }
+    if (pHdr->Seq == gmc.ExpectedSequence.load()) {
+        // The received sequence matches the expected one
+        gmc.ExpectedSequence++;
+        gmc.Sequence.store(pHdr->Seq);
+    } else if (pHdr->Seq > gmc.ExpectedSequence.load()) {
+        // If it's not the first packet then-->drops. Otherwise expected a new seq.
+        if (gmc.Packets.load() != 0)
+            gmc.RxDropped += pHdr->Seq - gmc.ExpectedSequence.load();
+        gmc.ExpectedSequence.store(pHdr->Seq + 1);
+        gmc.Sequence.store(pHdr->Seq);
+    } else {
+        // Out of order packets
+        if (gmc.RxDropped.load() > 0)
+            gmc.RxDropped--;
+        gmc.OutOfOrder++;
+    }
+    gmc.Packets++;
+    gmc.Bytes.fetch_add(pktSize);
+}
+
+/**
+ * @brief Account a sent packet in its group statistics.
+ */
+inline void UpdateTxStats(McGroupStats_t& gmc, const size_t pktSize) {
+    gmc.Sequence.store(gmc.Packets.load());  // Sequence is behind 1.
+    gmc.Packets++;
+    gmc.Bytes.fetch_add(pktSize);
+}
+
+}  // namespace riosession
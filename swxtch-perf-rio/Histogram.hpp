@@ -0,0 +1,167 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <thread>
+#if defined _MSC_VER
+    #include <intrin.h>
+#endif
+// clang-format on
+
+namespace riosession {
+
+/**
+ * @brief Log-linear histogram of nanosecond values: every power of two is split in
+ * SUB_BUCKETS linear buckets, so a value is recorded with a relative error below 1/SUB_BUCKETS
+ * (6%) from 1ns to 2^64ns in a fixed 8 KB table. Recording is a bit scan and an increment,
+ * cheap enough for the hot thread. Not thread safe: one writer, read once it stopped.
+ */
+class LatencyHistogram {
+   public:
+    static constexpr uint32_t SUB_BUCKET_BITS = 4;
+    static constexpr uint32_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr uint32_t BUCKETS = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;
+
+    void Record(uint64_t valueNs) {
+        m_Counts[Index(valueNs)]++;
+        m_Count++;
+        m_Sum += valueNs;
+        m_Min = std::min(m_Min, valueNs);
+        m_Max = std::max(m_Max, valueNs);
+    }
+
+    /**
+     * @brief Add the values recorded in @p other.
+     */
+    void Merge(const LatencyHistogram& other) {
+        for (uint32_t i = 0; i < BUCKETS; i++) {
+            m_Counts[i] += other.m_Counts[i];
+        }
+        m_Count += other.m_Count;
+        m_Sum += other.m_Sum;
+        m_Min = std::min(m_Min, other.m_Min);
+        m_Max = std::max(m_Max, other.m_Max);
+    }
+
+    uint64_t Count() const {
+        return m_Count;
+    }
+    uint64_t Min() const {
+        return m_Count ? m_Min : 0;
+    }
+    uint64_t Max() const {
+        return m_Max;
+    }
+    double Mean() const {
+        return m_Count ? static_cast<double>(m_Sum) / m_Count : 0.0;
+    }
+
+    /**
+     * @brief Value below which @p percentile percent of the values fall, reported as the upper
+     * bound of its bucket (clamped to the maximum recorded).
+     */
+    uint64_t Percentile(double percentile) const {
+        if (m_Count == 0) {
+            return 0;
+        }
+        const auto rank = static_cast<uint64_t>(percentile / 100.0 * (m_Count - 1)) + 1;
+        uint64_t seen = 0;
+        for (uint32_t i = 0; i < BUCKETS; i++) {
+            seen += m_Counts[i];
+            if (seen >= rank) {
+                return std::min(UpperBound(i), m_Max);
+            }
+        }
+        return m_Max;
+    }
+
+   private:
+    static uint32_t MostSignificantBit(uint64_t value) {
+#if defined _MSC_VER
+        unsigned long bit;
+        _BitScanReverse64(&bit, value);
+        return bit;
+#else
+        return 63 - __builtin_clzll(value);
+#endif
+    }
+
+    static uint32_t Index(uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return static_cast<uint32_t>(value);
+        }
+        const uint32_t msb = MostSignificantBit(value);
+        const uint32_t shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS
+               + static_cast<uint32_t>((value >> shift) & (SUB_BUCKETS - 1));
+    }
+
+    static uint64_t UpperBound(uint32_t index) {
+        if (index < 2 * SUB_BUCKETS) {
+            return index;
+        }
+        const uint32_t shift = index / SUB_BUCKETS - 1;
+        const uint64_t lower = static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+        return lower + ((1ULL << shift) - 1);
+    }
+
+    std::array<uint64_t, BUCKETS> m_Counts{};
+    uint64_t m_Count = 0;
+    uint64_t m_Sum = 0;
+    uint64_t m_Min = UINT64_MAX;
+    uint64_t m_Max = 0;
+};
+
+/**
+ * @brief LatencyHistogram written by the hot thread and taken per report interval by another
+ *  thread, without locks. There are two histograms: the reader switches the one the writer uses
+ *  and waits for the writer to leave the other, which lasts at most one batch.
+ *  The writer announces the histogram it writes before each batch, then checks it is still the
+ *  active one (Dekker style, two sequentially consistent stores per batch); the reader switches
+ *  the active one, then checks the announced one.
+ */
+class IntervalHistogram {
+   public:
+    /**
+     * @brief Writer: histogram to record the next batch into, until EndBatch.
+     */
+    inline LatencyHistogram& BeginBatch() {
+        uint32_t index = m_Active.load();
+        m_Writing.store(index);
+        if (m_Active.load() != index) {
+            index ^= 1;
+            m_Writing.store(index);
+        }
+        return m_Histograms[index];
+    }
+
+    inline void EndBatch() {
+        m_Writing.store(NOT_WRITING, std::memory_order_release);
+    }
+
+    /**
+     * @brief Reader: move the values recorded since the previous call out. One reader at a
+     *  time.
+     */
+    LatencyHistogram Take() {
+        const uint32_t index = m_Active.load();
+        m_Active.store(index ^ 1);
+        while (m_Writing.load() == index) {
+            std::this_thread::yield();
+        }
+        LatencyHistogram interval = m_Histograms[index];
+        m_Histograms[index] = LatencyHistogram{};
+        return interval;
+    }
+
+   private:
+    static constexpr uint32_t NOT_WRITING = 2;
+
+    std::array<LatencyHistogram, 2> m_Histograms;
+    std::atomic<uint32_t> m_Active = 0;
+    std::atomic<uint32_t> m_Writing = NOT_WRITING;
+};
+
+}  // namespace riosession
@@ -0,0 +1,94 @@
+#include "LoopbackRunner.hpp"
+// clang-format off
+#include <atomic>
+#include <future>
+#include <thread>
+#include "RioProducer.hpp"
+// clang-format on
+
+namespace riosession {
+
+LoopbackResult_t LoopbackRunner::Run(args_t producerArgs, args_t consumerArgs) {
+    producerArgs.Command = PRODUCER_COMMAND;
+    producerArgs.CoreSlot = PRODUCER_CORE_SLOT;
+    consumerArgs.Command = producerArgs.Rtt ? REFLECTOR_COMMAND : CONSUMER_COMMAND;
+    consumerArgs.PktsToCount = 0;
+    consumerArgs.SecondsToRun = 0;
+    consumerArgs.CoreSlot = 0;
+    producerArgs.Control = CONTROL_OFF;
+    consumerArgs.Control = CONTROL_OFF;
+    consumerArgs.Aggregator = AGGREGATOR_OFF;
+    if (consumerArgs.NumaNode < 0) {
+        producerArgs.NumaNode = 0;
+        consumerArgs.NumaNode = 0;
+    }
+
+    volatile sig_atomic_t consumerExit = 0;
+    volatile sig_atomic_t producerExit = 0;
+    std::unique_ptr<RioConsumer> consumer;
+    std::unique_ptr<RioProducer> producer;
+    std::promise<void> consumerReady;
+    std::atomic<bool> producerDone = false;
+
+    std::thread consumerThread([&]() {
+        try {
+            consumer = std::make_unique<RioConsumer>(&consumerArgs, &consumerExit);
+            consumerReady.set_value();
+        } catch (...) {
+            consumerReady.set_exception(std::current_exception());
+            return;
+        }
+        consumer->Start();
+    });
+    try {
+        consumerReady.get_future().get();
+    } catch (...) {
+        consumerThread.join();
+        throw;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOOPBACK_SETTLE_MS));
+
+    std::exception_ptr producerError;
+    auto sendStart = std::chrono::steady_clock::now();
+    std::thread producerThread([&]() {
+        try {
+            producer = std::make_unique<RioProducer>(&producerArgs, &producerExit);
+            producer->Start();
+        } catch (...) {
+            producerError = std::current_exception();
+        }
+        producerDone = true;
+    });
+    while (!producerDone) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (*m_ExitSignal) {
+            producerExit = 1;
+        }
+    }
+    producerThread.join();
+    auto sendStop = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::milliseconds(LOOPBACK_DRAIN_MS));
+    consumerExit = 1;
+    consumerThread.join();
+
+    LoopbackResult_t result;
+    result.SendMs
+        = std::chrono::duration_cast<std::chrono::milliseconds>(sendStop - sendStart).count();
+    if (producer) {
+        result.Sent = producer->TotalPackets();
+        result.Rtt = producer->Rtt();
+        producer->CleanUpRIO();
+    }
+    result.Received = consumer->GetMcTotals();
+    result.Latency = consumer->Latency();
+    if (consumer->Churn()) {
+        result.Churn = *consumer->Churn();
+    }
+    consumer->CleanUpRIO();
+    if (producerError) {
+        std::rethrow_exception(producerError);
+    }
+    return result;
+}
+
+}  // namespace riosession
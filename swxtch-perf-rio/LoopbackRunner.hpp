@@ -0,0 +1,51 @@
+#pragma once
+// clang-format off
+#include <signal.h>
+#include <stdint.h>
+#include "RioConsumer.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr int LOOPBACK_DRAIN_MS = 500;   // Left to the consumer after the producer stops
+constexpr int LOOPBACK_SETTLE_MS = 200;  // Left to the consumer to prepost its receives
+constexpr uint32_t PRODUCER_CORE_SLOT = 2;
+
+struct LoopbackResult_t {
+    uint64_t Sent = 0;
+    uint64_t SendMs = 0;
+    TotalStats_t Received;
+    LatencyHistogram Latency;
+    LatencyHistogram Rtt;  // With a producer --rtt
+    ChurnReport_t Churn;  // With a consumer --churn_rate
+
+    /**
+     * @brief Packets lost: Seq gaps, or the shortfall since drops at the tail of the run
+     * leave no gap.
+     */
+    uint64_t Lost() const {
+        return std::max(Received.TotalDrops, Sent - std::min(Sent, Received.TotalPackets));
+    }
+};
+
+/**
+ * @brief Run a producer and a consumer session in this process, on the same interface: the
+ * consumer gets the traffic through multicast loopback (or to its own address with --unicast),
+ * and with a producer --rtt reflects it back (see the reflector command). Each session is
+ * built and run on its own thread with its own exit flag, the consumer threads pinned from
+ * processor 0 of the NUMA node and the producer ones from PRODUCER_CORE_SLOT (node 0 when the
+ * NIC's is unknown).
+ * The producer runs until its --seconds / --total_pkts, the consumer is stopped
+ * LOOPBACK_DRAIN_MS later so packets still queued are counted. Ctrl-C stops both.
+ */
+class LoopbackRunner {
+   public:
+    LoopbackRunner(volatile sig_atomic_t* signal) : m_ExitSignal(signal) {
+    }
+    LoopbackResult_t Run(args_t producerArgs, args_t consumerArgs);
+
+   private:
+    volatile sig_atomic_t* m_ExitSignal;
+};
+
+}  // namespace riosession
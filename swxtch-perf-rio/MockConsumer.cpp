@@ -0,0 +1,37 @@
+#include "MockConsumer.hpp"
+// clang-format off
+#include <stdio.h>
+#include <algorithm>
+#include "MockTransport.hpp"
+// clang-format on
+
+namespace riosession {
+
+bool MockConsumer::Start() {
+    MockConfig_t config;
+    config.Groups = static_cast<uint32_t>(m_Args->McastAddrStr.size());
+    config.PayloadSize = static_cast<uint32_t>(m_Args->PayloadSize);
+    config.LossPct = m_Args->LossPct;
+    config.ReorderPct = m_Args->ReorderPct;
+    MockTransport transport(config);
+    const uint64_t cycles = std::max<uint64_t>(m_Args->PktsToCount / transport.CycleLength(), 1);
+
+    StageProfile stages;
+    auto run = RunMockConsumer(transport, cycles, &stages);
+
+    const double pps = run.ElapsedNs ? run.Completions * 1e9 / run.ElapsedNs : 0.0;
+    printf("\nMock consumer: %d bytes payload, %u groups, %.2f%% loss, %.2f%% reorder\n",
+           m_Args->PayloadSize, config.Groups, config.LossPct, config.ReorderPct);
+    printf("\tProcessed %llu completions in %.1f ms: %.0f pps, %.1f ns per packet\n",
+           run.Completions, run.ElapsedNs / 1e6, pps,
+           run.Completions ? static_cast<double>(run.ElapsedNs) / run.Completions : 0.0);
+    printf("\tCounted: %llu packets, %llu drops, %llu out of order\n", run.Counted.TotalPackets,
+           run.Counted.TotalDrops, run.Counted.TotalOutOfOrder);
+    printf("\tInjected: %llu packets, %llu drops, %llu out of order\n",
+           run.Expected.TotalPackets, run.Expected.TotalDrops, run.Expected.TotalOutOfOrder);
+    stages.PrintTotals("Mock consumer");
+    printf("Accounting %s\n", run.Matches() ? "MATCHES" : "DOES NOT MATCH");
+    return run.Matches();
+}
+
+}  // namespace riosession
@@ -0,0 +1,27 @@
+#pragma once
+// clang-format off
+#include "args.hpp"
+// clang-format on
+
+namespace riosession {
+
+/**
+ * @brief Processing ceiling of the consumer: its completion loop runs over MockTransport, with
+ * one synthetic group per --mcast_ip group, --payload_size datagrams and --loss_pct/--reorder_pct
+ * injected, for about --total_pkts packets. No NIC, socket nor RIO is involved, so the packets
+ * per second reached are what the application logic itself handles on one core.
+ */
+class MockConsumer {
+   public:
+    explicit MockConsumer(args_t* args) : m_Args(args) {
+    }
+    /**
+     * @return bool true when the loss and reordering counted match the injected ones
+     */
+    bool Start();
+
+   private:
+    args_t* m_Args;
+};
+
+}  // namespace riosession
@@ -0,0 +1,112 @@
+#include "MockTransport.hpp"
+// clang-format off
+#include <algorithm>
+#include <chrono>
+#include <random>
+#include "RecvProcessor.hpp"
+// clang-format on
+
+namespace riosession {
+
+MockTransport::MockTransport(const MockConfig_t& config)
+    : m_Config(config),
+      m_Slot(config.PayloadSize),
+      m_Ring(std::make_unique<char[]>(static_cast<size_t>(m_Slot.Stride) * config.RingSize)),
+      m_Posted(static_cast<size_t>(config.RingSize) + 1) {
+    BuildCycle();
+}
+
+/**
+ * @brief Build the packets of one cycle, applying loss and reordering per group, then
+ *  interleave the groups round robin.
+ */
+void MockTransport::BuildCycle() {
+    std::mt19937 rng(m_Config.Seed);
+    std::uniform_real_distribution<double> percent(0.0, 100.0);
+    std::vector<std::vector<uint32_t>> groupSeqs(m_Config.Groups);
+
+    for (auto& seqs : groupSeqs) {
+        uint64_t trailing = 0;
+        for (uint32_t seq = 0; seq < m_Config.CyclePerGroup; seq++) {
+            if (seq != 0 && percent(rng) < m_Config.LossPct) {
+                m_LostPerCycle++;
+                trailing++;
+                continue;
+            }
+            trailing = 0;
+            seqs.push_back(seq);
+        }
+        m_TrailingLost += trailing;
+        // Each swap is seen as one out of order packet, its gap is cancelled when it arrives
+        for (size_t i = 1; i + 1 < seqs.size(); i++) {
+            if (percent(rng) < m_Config.ReorderPct) {
+                std::swap(seqs[i], seqs[i + 1]);
+                m_ReorderedPerCycle++;
+                i++;
+            }
+        }
+    }
+
+    for (size_t i = 0; i < m_Config.CyclePerGroup; i++) {
+        for (uint32_t group = 0; group < m_Config.Groups; group++) {
+            if (i < groupSeqs[group].size()) {
+                m_Cycle.push_back(Packet_t{group, groupSeqs[group][i]});
+            }
+        }
+    }
+}
+
+TotalStats_t MockTransport::Expected(uint64_t cycles) const {
+    TotalStats_t expected;
+    expected.TotalPackets = cycles * m_Cycle.size();
+    expected.TotalBytes = expected.TotalPackets * m_Slot.DataSize;
+    expected.TotalOutOfOrder = cycles * m_ReorderedPerCycle;
+    expected.TotalDrops = cycles ? cycles * m_LostPerCycle - m_TrailingLost : 0;
+    return expected;
+}
+
+McGroupStatsMap MockGroupStats(const MockConfig_t& config) {
+    McGroupStatsMap groupStats;
+    for (uint32_t group = 0; group < config.Groups; group++) {
+        groupStats[MakeStreamKey(htonl(MOCK_FIRST_GROUP + group), 0)];
+    }
+    return groupStats;
+}
+
+MockRunResult_t RunMockConsumer(MockTransport& transport,
+                                uint64_t cycles,
+                                StageProfile* stages) {
+    McGroupStatsMap groupStats = MockGroupStats(transport.Config());
+    RcuValue<StreamTable> streams{StreamTable(groupStats)};
+    RecvProcessor<> processor(transport.Slot(), transport.Ring(), &streams, nullptr, stages);
+    for (ULONG slot = 0; slot < transport.Config().RingSize; slot++) {
+        transport.PostRecv(slot);
+    }
+
+    MockRunResult_t run;
+    RIORESULT results[MAX_RIO_RESULTS];
+    const uint64_t completions = cycles * transport.CycleLength();
+    auto start = std::chrono::steady_clock::now();
+    while (run.Completions < completions) {
+        const uint64_t remaining = completions - run.Completions;
+        auto maxResults = static_cast<ULONG>(std::min<uint64_t>(MAX_RIO_RESULTS, remaining));
+        uint64_t tsc = StageProfile::Now();
+        ULONG numResults = transport.Dequeue(results, maxResults);
+        if (stages) {
+            stages->Mark(Stage::Dequeue, tsc);
+        }
+        processor.Process(results, numResults, 0,
+                          [&transport](const RIORESULT& result) {
+                              transport.Repost(result.RequestContext);
+                          });
+        run.Completions += numResults;
+    }
+    run.ElapsedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+    run.Counted = SumStats(groupStats);
+    run.Expected = transport.Expected(cycles);
+    return run;
+}
+
+}  // namespace riosession
@@ -0,0 +1,145 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <memory>
+#include <vector>
+#include "GroupStats.hpp"
+#include "RecvSlot.hpp"
+#include "StageProbes.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr uint32_t MOCK_FIRST_GROUP = 0xEF000000;  // 239.0.0.0, host order
+constexpr uint32_t MOCK_CYCLE_PER_GROUP = 4096;    // Default sequences per group in a cycle
+
+struct MockConfig_t {
+    uint32_t Groups = 1;
+    uint32_t PayloadSize = 100;
+    ULONG RingSize = 65536;   // Preposted receives
+    double LossPct = 0.0;     // Sequences never delivered
+    double ReorderPct = 0.0;  // Packets delivered after the next one of their group
+    uint32_t Seed = 1;
+    uint32_t CyclePerGroup = MOCK_CYCLE_PER_GROUP;  // Lower it for many groups
+};
+
+/**
+ * @brief Stand-in for the RIO receive path that serves completions at memory speed, so the
+ *  consumer's processing and statistics can be measured (and checked) without a network.
+ *
+ *  A cycle of synthetic packets is built up front: CyclePerGroup sequences per group,
+ *  interleaved, with LossPct of them removed and ReorderPct swapped with the next packet of
+ *  their group (the first sequence of a group in a cycle is never lost nor moved). Posting a
+ *  receive writes the next packet of the cycle in the slot, header and group address, as the
+ *  NIC would; the cycle repeats with sequences shifted by CyclePerGroup. Completions are
+ *  returned in post order. The same seed gives the same traffic.
+ */
+class MockTransport {
+   public:
+    explicit MockTransport(const MockConfig_t& config);
+
+    /**
+     * @brief "Receive" the next packet of the cycle into @p slot and queue its completion.
+     */
+    inline void PostRecv(ULONG slot) {
+        const Packet_t& packet = m_Cycle[m_NextPacket];
+        auto pHeader = reinterpret_cast<ProtocolHeader_t*>(m_Slot.Data(m_Ring.get(), slot));
+        FillHeader(pHeader, m_CycleCount * m_Config.CyclePerGroup + packet.Seq, 0);
+        auto addr = m_Slot.Addr(m_Ring.get(), slot);
+        addr->Ipv4.sin_family = AF_INET;
+        addr->Ipv4.sin_addr.s_addr = htonl(MOCK_FIRST_GROUP + packet.Group);
+        if (++m_NextPacket == m_Cycle.size()) {
+            m_NextPacket = 0;
+            m_CycleCount++;
+        }
+
+        m_Posted[m_PostTail] = slot;
+        m_PostTail = (m_PostTail + 1) % m_Posted.size();
+    }
+
+    inline void Repost(ULONGLONG context) {
+        PostRecv(static_cast<ULONG>(context));
+    }
+
+    /**
+     * @brief Return up to @p maxResults completions of the posted receives, oldest first.
+     */
+    inline ULONG Dequeue(RIORESULT* results, ULONG maxResults) {
+        ULONG numResults = 0;
+        while (numResults < maxResults && m_PostHead != m_PostTail) {
+            results[numResults++] = RIORESULT{0, m_Slot.DataSize, 0, m_Posted[m_PostHead]};
+            m_PostHead = (m_PostHead + 1) % m_Posted.size();
+        }
+        return numResults;
+    }
+
+    char* Ring() const {
+        return m_Ring.get();
+    }
+    const RecvSlotLayout_t& Slot() const {
+        return m_Slot;
+    }
+    const MockConfig_t& Config() const {
+        return m_Config;
+    }
+    uint64_t CycleLength() const {
+        return m_Cycle.size();
+    }
+
+    /**
+     * @brief What UpdateRxStats must count once @p cycles whole cycles were delivered. Losses
+     *  at the end of the last cycle are not seen yet, there is no later packet to reveal them.
+     */
+    TotalStats_t Expected(uint64_t cycles) const;
+
+   private:
+    struct Packet_t {
+        uint32_t Group;
+        uint32_t Seq;  // Within the cycle
+    };
+
+    void BuildCycle();
+
+    MockConfig_t m_Config;
+    RecvSlotLayout_t m_Slot;
+    std::unique_ptr<char[]> m_Ring;
+    std::vector<Packet_t> m_Cycle;
+    uint64_t m_LostPerCycle = 0;
+    uint64_t m_ReorderedPerCycle = 0;
+    uint64_t m_TrailingLost = 0;  // Lost at the end of a cycle, seen in the next one
+    size_t m_NextPacket = 0;
+    uint64_t m_CycleCount = 0;
+    std::vector<ULONG> m_Posted;  // FIFO of posted slots, RingSize + 1 entries
+    size_t m_PostHead = 0;
+    size_t m_PostTail = 0;
+};
+
+struct MockRunResult_t {
+    uint64_t Completions = 0;
+    uint64_t ElapsedNs = 0;
+    TotalStats_t Counted;
+    TotalStats_t Expected;
+
+    bool Matches() const {
+        return Counted.TotalPackets == Expected.TotalPackets
+               && Counted.TotalBytes == Expected.TotalBytes
+               && Counted.TotalOutOfOrder == Expected.TotalOutOfOrder
+               && Counted.TotalDrops == Expected.TotalDrops;
+    }
+};
+
+/**
+ * @brief Statistics of every stream of the synthetic traffic, port 0.
+ */
+McGroupStatsMap MockGroupStats(const MockConfig_t& config);
+
+/**
+ * @brief Run the consumer completion loop (dequeue, RecvProcessor, repost) over @p cycles
+ *  whole cycles of @p transport and compare what it counted with what was injected.
+ *  @p stages, if given, gets the dequeue, process and repost cycles.
+ */
+MockRunResult_t RunMockConsumer(MockTransport& transport,
+                                uint64_t cycles,
+                                StageProfile* stages = nullptr);
+
+}  // namespace riosession
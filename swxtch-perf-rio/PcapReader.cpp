@@ -0,0 +1,353 @@
+#include "PcapReader.hpp"
+#include "Utilities.hpp"
+
+namespace riosession {
+
+namespace {
+constexpr uint32_t PCAP_MAGIC_US = 0xa1b2c3d4;
+constexpr uint32_t PCAP_MAGIC_NS = 0xa1b23c4d;
+constexpr uint32_t PCAP_GLOBAL_HDR_SIZE = 24;
+constexpr uint32_t PCAP_RECORD_HDR_SIZE = 16;
+constexpr uint32_t PCAPNG_SHB = 0x0a0d0d0a;
+constexpr uint32_t PCAPNG_IDB = 0x00000001;
+constexpr uint32_t PCAPNG_SPB = 0x00000003;
+constexpr uint32_t PCAPNG_EPB = 0x00000006;
+constexpr uint32_t PCAPNG_BYTE_ORDER_MAGIC = 0x1a2b3c4d;
+constexpr uint16_t PCAPNG_OPT_IF_TSRESOL = 9;
+
+constexpr uint32_t LINKTYPE_NULL = 0;
+constexpr uint32_t LINKTYPE_ETHERNET = 1;
+constexpr uint32_t LINKTYPE_RAW = 101;
+constexpr uint32_t LINKTYPE_RAW_OLD = 12;
+constexpr uint32_t LINKTYPE_IPV4 = 228;
+constexpr uint32_t LINKTYPE_LINUX_SLL = 113;
+constexpr uint32_t LINKTYPE_LINUX_SLL2 = 276;
+
+constexpr uint16_t ETHERTYPE_IPV4 = 0x0800;
+constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+constexpr uint16_t ETHERTYPE_QINQ = 0x88a8;
+constexpr uint8_t IP_PROTO_UDP = 17;
+constexpr uint32_t UDP_HDR_SIZE = 8;
+
+inline uint16_t Swap16(uint16_t v) {
+    return static_cast<uint16_t>((v >> 8) | (v << 8));
+}
+
+inline uint32_t Swap32(uint32_t v) {
+    return ((v >> 24) & 0xff) | ((v >> 8) & 0xff00) | ((v << 8) & 0xff0000) | (v << 24);
+}
+
+inline uint16_t Load16(const uint8_t* p, bool swap) {
+    uint16_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? Swap16(v) : v;
+}
+
+inline uint32_t Load32(const uint8_t* p, bool swap) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return swap ? Swap32(v) : v;
+}
+
+// Network headers are always big endian
+inline uint16_t LoadBe16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+[[noreturn]] void Malformed(const std::string& what) {
+    throw std::runtime_error("--- Malformed capture file: " + what);
+}
+}  // namespace
+
+/**
+ * @brief Map the capture file and build the packet index.
+ *
+ * @param path pcap or pcapng file
+ */
+PcapReader::PcapReader(const std::string& path) {
+    try {
+        Open(path);
+    } catch (...) {
+        Close();  // The destructor does not run when the constructor throws
+        throw;
+    }
+}
+
+PcapReader::~PcapReader() {
+    Close();
+}
+
+void PcapReader::Open(const std::string& path) {
+    m_File = ::CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+    if (m_File == INVALID_HANDLE_VALUE) {
+        throw std::runtime_error("--- Unable to open " + path + ": "
+                                 + utilities::GetLastErrorMessage(::GetLastError()));
+    }
+    LARGE_INTEGER fileSize;
+    if (!::GetFileSizeEx(m_File, &fileSize) || fileSize.QuadPart < PCAP_GLOBAL_HDR_SIZE) {
+        Malformed(path + " is too small");
+    }
+    m_Size = static_cast<uint64_t>(fileSize.QuadPart);
+    m_Mapping = ::CreateFileMappingW(m_File, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_Mapping == NULL) {
+        throw std::runtime_error("--- CreateFileMapping failed: "
+                                 + utilities::GetLastErrorMessage(::GetLastError()));
+    }
+    m_View = reinterpret_cast<const uint8_t*>(::MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+    if (m_View == nullptr) {
+        throw std::runtime_error("--- MapViewOfFile failed: "
+                                 + utilities::GetLastErrorMessage(::GetLastError()));
+    }
+
+    uint32_t magic = Load32(m_View, false);
+    if (magic == PCAPNG_SHB) {
+        ParsePcapNg();
+    } else {
+        ParsePcap();
+    }
+    if (m_Packets.empty()) {
+        throw std::runtime_error("--- No IPv4/UDP datagrams found in " + path);
+    }
+}
+
+void PcapReader::Close() {
+    if (m_View) {
+        ::UnmapViewOfFile(m_View);
+        m_View = nullptr;
+    }
+    if (m_Mapping) {
+        ::CloseHandle(m_Mapping);
+        m_Mapping = NULL;
+    }
+    if (m_File != INVALID_HANDLE_VALUE) {
+        ::CloseHandle(m_File);
+        m_File = INVALID_HANDLE_VALUE;
+    }
+}
+
+/**
+ * @brief Time between the first and the last datagram of the capture
+ *
+ * @return uint64_t nanoseconds
+ */
+uint64_t PcapReader::DurationNs() const {
+    const uint64_t first = m_Packets.front().TimestampNs;
+    const uint64_t last = m_Packets.back().TimestampNs;
+    return (last > first) ? last - first : 0;
+}
+
+/**
+ * @brief Classic libpcap format, either byte order, microsecond or nanosecond timestamps.
+ */
+void PcapReader::ParsePcap() {
+    uint32_t magic = Load32(m_View, false);
+    bool swap = false;
+    bool nanoRes = false;
+    if (magic == PCAP_MAGIC_US || magic == PCAP_MAGIC_NS) {
+        nanoRes = (magic == PCAP_MAGIC_NS);
+    } else if (Swap32(magic) == PCAP_MAGIC_US || Swap32(magic) == PCAP_MAGIC_NS) {
+        swap = true;
+        nanoRes = (Swap32(magic) == PCAP_MAGIC_NS);
+    } else {
+        Malformed("unknown magic number");
+    }
+    const uint32_t linkType = Load32(m_View + 20, swap) & 0xffff;
+
+    uint64_t offset = PCAP_GLOBAL_HDR_SIZE;
+    while (offset + PCAP_RECORD_HDR_SIZE <= m_Size) {
+        const uint8_t* rec = m_View + offset;
+        const uint64_t tsSec = Load32(rec, swap);
+        const uint64_t tsFrac = Load32(rec + 4, swap);
+        const uint32_t capLen = Load32(rec + 8, swap);
+        offset += PCAP_RECORD_HDR_SIZE;
+        if (offset + capLen > m_Size) {
+            // Truncated last record, typical of a capture that was interrupted
+            break;
+        }
+        const uint64_t tsNs = tsSec * utilities::ONE_SECOND + (nanoRes ? tsFrac : tsFrac * 1000);
+        AddFrame(linkType, m_View + offset, capLen, tsNs);
+        offset += capLen;
+    }
+}
+
+/**
+ * @brief pcapng format. Handles several sections and interfaces, enhanced and simple packet
+ * blocks and the if_tsresol option. Any other block type is skipped.
+ */
+void PcapReader::ParsePcapNg() {
+    struct Interface_t {
+        uint32_t LinkType;
+        uint64_t UnitsPerSec;
+    };
+    std::vector<Interface_t> interfaces;
+    bool swap = false;
+
+    uint64_t offset = 0;
+    while (offset + 12 <= m_Size) {
+        const uint8_t* block = m_View + offset;
+        uint32_t type = Load32(block, false);
+        if (type == PCAPNG_SHB) {
+            // The byte order of a section is given by its own header
+            uint32_t bom = Load32(block + 8, false);
+            if (bom == PCAPNG_BYTE_ORDER_MAGIC) {
+                swap = false;
+            } else if (Swap32(bom) == PCAPNG_BYTE_ORDER_MAGIC) {
+                swap = true;
+            } else {
+                Malformed("bad section byte order magic");
+            }
+            interfaces.clear();
+        } else {
+            type = swap ? Swap32(type) : type;
+        }
+        const uint32_t blockLen = Load32(block + 4, swap);
+        if (blockLen < 12 || (blockLen % 4) != 0 || offset + blockLen > m_Size) {
+            break;
+        }
+        const uint8_t* body = block + 8;
+        const uint32_t bodyLen = blockLen - 12;
+
+        if (type == PCAPNG_IDB && bodyLen >= 8) {
+            Interface_t itf{Load16(body, swap), 1000000};
+            // Options follow the fixed part: code(16) length(16) value padded to 32 bits
+            uint32_t opt = 8;
+            while (opt + 4 <= bodyLen) {
+                uint16_t code = Load16(body + opt, swap);
+                uint16_t len = Load16(body + opt + 2, swap);
+                if (code == 0) {
+                    break;
+                }
+                if (code == PCAPNG_OPT_IF_TSRESOL && len == 1 && opt + 5 <= bodyLen) {
+                    uint8_t res = body[opt + 4];
+                    uint8_t exp = res & 0x7f;
+                    itf.UnitsPerSec = 1;
+                    for (uint8_t i = 0; i < exp; i++) {
+                        itf.UnitsPerSec *= (res & 0x80) ? 2 : 10;
+                    }
+                }
+                opt += 4 + ((len + 3u) & ~3u);
+            }
+            interfaces.push_back(itf);
+        } else if (type == PCAPNG_EPB && bodyLen >= 20) {
+            const uint32_t ifId = Load32(body, swap);
+            if (ifId >= interfaces.size()) {
+                Malformed("packet block references an unknown interface");
+            }
+            const uint64_t ts
+                = (static_cast<uint64_t>(Load32(body + 4, swap)) << 32) | Load32(body + 8, swap);
+            const uint32_t capLen = std::min(Load32(body + 12, swap), bodyLen - 20);
+            const auto& itf = interfaces[ifId];
+            // Split to avoid overflowing 64 bits with nanosecond units
+            const uint64_t tsNs = (ts / itf.UnitsPerSec) * utilities::ONE_SECOND
+                                  + (ts % itf.UnitsPerSec) * utilities::ONE_SECOND / itf.UnitsPerSec;
+            AddFrame(itf.LinkType, body + 20, capLen, tsNs);
+        } else if (type == PCAPNG_SPB && bodyLen >= 4 && !interfaces.empty()) {
+            // Simple packet blocks carry no timestamp: they are replayed back to back
+            const uint32_t capLen = std::min(Load32(body, swap), bodyLen - 4);
+            const uint64_t tsNs = m_Packets.empty() ? 0 : m_Packets.back().TimestampNs;
+            AddFrame(interfaces[0].LinkType, body + 4, capLen, tsNs);
+        }
+        offset += blockLen;
+    }
+}
+
+/**
+ * @brief Strip the link layer, IPv4 and UDP headers of a frame and index its payload.
+ * Non IPv4, non UDP and fragmented datagrams are ignored.
+ */
+void PcapReader::AddFrame(uint32_t linkType,
+                          const uint8_t* frame,
+                          uint32_t capLen,
+                          uint64_t tsNs) {
+    uint32_t l3 = 0;
+    switch (linkType) {
+        case LINKTYPE_ETHERNET: {
+            if (capLen < 14) {
+                return;
+            }
+            uint16_t etherType = LoadBe16(frame + 12);
+            l3 = 14;
+            while ((etherType == ETHERTYPE_VLAN || etherType == ETHERTYPE_QINQ)
+                   && capLen >= l3 + 4) {
+                etherType = LoadBe16(frame + l3 + 2);
+                l3 += 4;
+            }
+            if (etherType != ETHERTYPE_IPV4) {
+                return;
+            }
+            break;
+        }
+        case LINKTYPE_NULL:
+            // 4 byte address family in the byte order of the capturing host
+            if (capLen < 4 || (frame[0] != AF_INET && frame[3] != AF_INET)) {
+                return;
+            }
+            l3 = 4;
+            break;
+        case LINKTYPE_LINUX_SLL:
+            if (capLen < 16 || LoadBe16(frame + 14) != ETHERTYPE_IPV4) {
+                return;
+            }
+            l3 = 16;
+            break;
+        case LINKTYPE_LINUX_SLL2:
+            if (capLen < 20 || LoadBe16(frame) != ETHERTYPE_IPV4) {
+                return;
+            }
+            l3 = 20;
+            break;
+        case LINKTYPE_RAW:
+        case LINKTYPE_RAW_OLD:
+        case LINKTYPE_IPV4:
+            l3 = 0;
+            break;
+        default:
+            return;
+    }
+
+    const uint8_t* ip = frame + l3;
+    const uint32_t ipAvail = capLen - l3;
+    if (ipAvail < 20 || (ip[0] >> 4) != 4 || ip[9] != IP_PROTO_UDP) {
+        return;
+    }
+    const uint32_t ihl = (ip[0] & 0x0f) * 4u;
+    const uint16_t fragment = LoadBe16(ip + 6);
+    if ((fragment & 0x3fff) != 0 || ipAvail < ihl + UDP_HDR_SIZE) {
+        // More-fragments flag or non zero offset
+        return;
+    }
+    const uint8_t* udp = ip + ihl;
+    const uint16_t udpLen = LoadBe16(udp + 4);
+    if (udpLen < UDP_HDR_SIZE) {
+        return;
+    }
+    const uint32_t payloadLen
+        = std::min<uint32_t>(udpLen - UDP_HDR_SIZE, ipAvail - ihl - UDP_HDR_SIZE);
+    if (payloadLen == 0) {
+        return;
+    }
+    uint32_t dstAddr;
+    memcpy(&dstAddr, ip + 16, sizeof(dstAddr));
+
+    PcapPacket_t pkt;
+    pkt.TimestampNs = tsNs;
+    pkt.Payload = reinterpret_cast<const char*>(udp + UDP_HDR_SIZE);
+    pkt.Length = payloadLen;
+    pkt.FlowId = GetFlowId(dstAddr, LoadBe16(udp + 2));
+    m_Packets.push_back(pkt);
+    m_MaxPayload = std::max(m_MaxPayload, payloadLen);
+}
+
+uint32_t PcapReader::GetFlowId(uint32_t dstAddr, uint16_t dstPort) {
+    uint64_t key = (static_cast<uint64_t>(dstAddr) << 16) | dstPort;
+    auto it = m_Flows.find(key);
+    if (it != m_Flows.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(m_Flows.size());
+    m_Flows.emplace(key, id);
+    return id;
+}
+
+}  // namespace riosession
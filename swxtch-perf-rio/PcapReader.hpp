@@ -0,0 +1,63 @@
+#pragma once
+// clang-format off
+#include "stdafx.h"
+#include <stdint.h>
+#include <string>
+#include <unordered_map>
+#include <vector>
+// clang-format on
+
+namespace riosession {
+
+/**
+ * @brief One UDP datagram found in a capture. Payload points straight into the mapped file.
+ * FlowId numbers the distinct destination (address, port) pairs in order of first appearance.
+ */
+struct PcapPacket_t {
+    uint64_t TimestampNs;
+    const char* Payload;
+    uint32_t Length;
+    uint32_t FlowId;
+};
+
+/**
+ * @brief Memory-maps a pcap or pcapng file read-only and indexes every IPv4/UDP datagram.
+ * Indexing walks the whole file once, so the replay loop never parses and every page of the
+ * capture is already resident when sending starts.
+ */
+class PcapReader {
+   public:
+    explicit PcapReader(const std::string& path);
+    ~PcapReader();
+    PcapReader(const PcapReader&) = delete;
+    PcapReader& operator=(const PcapReader&) = delete;
+
+    const std::vector<PcapPacket_t>& Packets() const {
+        return m_Packets;
+    }
+    uint32_t NumberOfFlows() const {
+        return static_cast<uint32_t>(m_Flows.size());
+    }
+    uint32_t MaxPayloadSize() const {
+        return m_MaxPayload;
+    }
+    uint64_t DurationNs() const;
+
+   private:
+    void Open(const std::string& path);
+    void Close();
+    void ParsePcap();
+    void ParsePcapNg();
+    void AddFrame(uint32_t linkType, const uint8_t* frame, uint32_t capLen, uint64_t tsNs);
+    uint32_t GetFlowId(uint32_t dstAddr, uint16_t dstPort);
+
+    HANDLE m_File = INVALID_HANDLE_VALUE;
+    HANDLE m_Mapping = NULL;
+    const uint8_t* m_View = nullptr;
+    uint64_t m_Size = 0;
+    std::vector<PcapPacket_t> m_Packets;
+    std::unordered_map<uint64_t, uint32_t> m_Flows;
+    uint32_t m_MaxPayload = 0;
+};
+
+}  // namespace riosession
@@ -0,0 +1,193 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <math.h>
+#include <algorithm>
+#include "StatsReport.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr double ADAPT_RESOLUTION = 0.02;  // Converged when the bad rate is this close above
+constexpr uint32_t ADAPT_MIN_RING_FREE_PCT = 10;  // Less of a receiver's ring left is a backlog
+constexpr double ADAPT_SEND_SHORTFALL = 0.9;  // Sending less of the rate is the producer's limit
+constexpr int ADAPT_REPROBE_PERIODS = 10;  // Good periods at the converged rate before probing up
+constexpr double ADAPT_REPROBE_STEP = 1.1;
+constexpr double ADAPT_PERIOD_SEC = 0.25;  // Producer report period, unless --report_ms
+
+enum class AdaptVerdict : uint32_t { Settling, NoFeedback, Good, Loss, Backlog, SendLimit };
+
+inline const char* AdaptVerdictName(AdaptVerdict verdict) {
+    switch (verdict) {
+        case AdaptVerdict::Settling:
+            return "settling";
+        case AdaptVerdict::NoFeedback:
+            return "no feedback";
+        case AdaptVerdict::Good:
+            return "good";
+        case AdaptVerdict::Loss:
+            return "loss";
+        case AdaptVerdict::Backlog:
+            return "backlog";
+        default:
+            return "send limit";
+    }
+}
+
+/**
+ * @brief What a period at Rate told, and the rate of the next one.
+ */
+struct AdaptStep_t {
+    AdaptVerdict Verdict = AdaptVerdict::Settling;
+    int64_t Rate = 0;
+    int64_t Next = 0;
+    size_t Receivers = 0;  // That reported traffic over the period
+    double WorstLossPct = 0;
+};
+
+/**
+ * @brief Closed loop search of the highest per stream rate at which every receiver keeps its
+ *  loss at most a threshold, without running its receive ring dry, from the reports the
+ *  receivers push (see StatsReport.hpp). The search starts in the geometric middle of the
+ *  range and bisects it geometrically, between the highest good rate (the minimum before any)
+ *  and the lowest bad one (the maximum before any), until they are ADAPT_RESOLUTION apart: the
+ *  1000 to 1 range of 1K to 1M pps takes 9 judged periods. Once converged it holds the good
+ *  rate and probes a little above it every ADAPT_REPROBE_PERIODS, and a good rate going bad
+ *  halves it and searches again below, so it follows the receivers when they change. The
+ *  period after a change settles: its reports mix both rates and are not judged.
+ */
+class RateAdapter {
+   public:
+    RateAdapter(double maxLossPct, int64_t minRate, int64_t maxRate)
+        : m_MaxLossPct(maxLossPct),
+          m_Rate(Middle(minRate, maxRate)),
+          m_MinRate(minRate),
+          m_MaxRate(maxRate) {
+    }
+
+    int64_t Rate() const {
+        return m_Rate;
+    }
+
+    /**
+     * @brief Highest rate found good, 0 before any.
+     */
+    int64_t Good() const {
+        return m_Good;
+    }
+
+    bool Converged() const {
+        return m_Good != 0 && Close(m_Good, Upper());
+    }
+
+    /**
+     * @brief Judge the period that ends with @p merged and pick the next rate.
+     *
+     * @param sentPps Packets per second the producer sent to each stream over the period
+     */
+    AdaptStep_t Step(const MergedPeriod_t& merged, double sentPps) {
+        AdaptStep_t step;
+        step.Rate = m_Rate;
+        if (m_Settling) {
+            m_Settling = false;
+            step.Next = m_Rate;
+            return step;
+        }
+        Judge(merged, sentPps, step);
+        if (step.Verdict == AdaptVerdict::Good) {
+            m_Good = m_Rate;
+            if (m_Bad != 0 && m_Bad <= m_Good) {
+                m_Bad = 0;  // The receivers got faster
+            }
+            if (!Converged()) {
+                step.Next = Middle(m_Good, Upper());
+            } else if (m_Bad != 0 && ++m_GoodPeriods >= ADAPT_REPROBE_PERIODS) {
+                m_GoodPeriods = 0;
+                m_Bad = static_cast<int64_t>(m_Bad * ADAPT_REPROBE_STEP);
+                m_Bad = m_Bad < m_MaxRate ? m_Bad : 0;
+                step.Next = Middle(m_Good, Upper());
+            } else {
+                step.Next = m_Rate;
+            }
+        } else if (step.Verdict != AdaptVerdict::NoFeedback) {
+            m_Bad = m_Rate;
+            if (m_Good >= m_Bad) {
+                m_Good = 0;  // The receivers got slower, search again below
+                step.Next = m_Rate / 2;
+            } else if (Close(Lower(), m_Bad)) {
+                step.Next = Lower();
+            } else {
+                step.Next = Middle(Lower(), m_Bad);
+            }
+            m_GoodPeriods = 0;
+        } else {
+            step.Next = m_Rate;
+        }
+        step.Next = std::clamp(step.Next, m_MinRate, m_MaxRate);
+        m_Settling = step.Next != m_Rate;
+        m_Rate = step.Next;
+        return step;
+    }
+
+   private:
+    static bool Close(int64_t good, int64_t bad) {
+        return bad - good <= std::max<int64_t>(static_cast<int64_t>(good * ADAPT_RESOLUTION), 1);
+    }
+
+    /**
+     * @brief Geometric middle of @p low and @p high, strictly between them when there is room.
+     */
+    static int64_t Middle(int64_t low, int64_t high) {
+        const auto middle = static_cast<int64_t>(llround(sqrt(static_cast<double>(low) * high)));
+        return high - low < 2 ? low : std::clamp(middle, low + 1, high - 1);
+    }
+
+    int64_t Lower() const {
+        return m_Good != 0 ? m_Good : m_MinRate;
+    }
+
+    int64_t Upper() const {
+        return m_Bad != 0 ? m_Bad : m_MaxRate;
+    }
+
+    /**
+     * @brief Bad when a receiver lost more than the threshold, or its ring ran dry or nearly
+     *  so, or the producer itself could not send the rate. Receivers silent or without traffic
+     *  over the period are not counted.
+     */
+    void Judge(const MergedPeriod_t& merged, double sentPps, AdaptStep_t& step) const {
+        bool backlog = false;
+        for (const auto& receiver : merged.Receivers) {
+            if (receiver.SilentNs != 0
+                || receiver.Counters.Packets + receiver.Counters.Drops == 0) {
+                continue;
+            }
+            step.Receivers++;
+            step.WorstLossPct = std::max(step.WorstLossPct, receiver.LossPct);
+            backlog = backlog || receiver.Overruns != 0
+                      || receiver.RingFreePct < ADAPT_MIN_RING_FREE_PCT;
+        }
+        if (step.Receivers == 0) {
+            step.Verdict = AdaptVerdict::NoFeedback;
+        } else if (step.WorstLossPct > m_MaxLossPct) {
+            step.Verdict = AdaptVerdict::Loss;
+        } else if (backlog) {
+            step.Verdict = AdaptVerdict::Backlog;
+        } else if (sentPps < m_Rate * ADAPT_SEND_SHORTFALL) {
+            step.Verdict = AdaptVerdict::SendLimit;
+        } else {
+            step.Verdict = AdaptVerdict::Good;
+        }
+    }
+
+    double m_MaxLossPct;
+    int64_t m_Rate;
+    int64_t m_MinRate;
+    int64_t m_MaxRate;
+    int64_t m_Good = 0;  // Highest rate found good, 0 for none
+    int64_t m_Bad = 0;   // Lowest rate found bad, 0 for none
+    int m_GoodPeriods = 0;  // At the converged rate
+    bool m_Settling = true;  // The first period ramps up from nothing
+};
+
+}  // namespace riosession
@@ -0,0 +1,72 @@
+#pragma once
+// clang-format off
+#include <atomic>
+#include <thread>
+#include <utility>
+// clang-format on
+
+namespace riosession {
+
+/**
+ * @brief Value read by the hot thread on every batch and replaced now and then by another
+ *  thread, read copy update style: a writer publishes a whole new version and the hot thread
+ *  switches to it at its next batch, without a lock nor a wait.
+ *  The hot thread announces the version it reads before each batch, then checks it is still
+ *  the current one (Dekker style, two sequentially consistent stores per batch, as
+ *  IntervalHistogram); a writer swaps the current version, then waits for the hot thread to
+ *  leave the previous one before freeing it, which lasts at most one batch. One reader,
+ *  writers serialized by the caller.
+ */
+template <typename T>
+class RcuValue {
+   public:
+    explicit RcuValue(T value = T{}) : m_Current(new T(std::move(value))) {
+    }
+    ~RcuValue() {
+        delete m_Current.load();
+    }
+    RcuValue(const RcuValue&) = delete;
+    RcuValue& operator=(const RcuValue&) = delete;
+
+    /**
+     * @brief Reader: version to use until Release.
+     */
+    inline const T& Acquire() {
+        const T* value = m_Current.load();
+        m_Reading.store(value);
+        while (m_Current.load() != value) {
+            value = m_Current.load();
+            m_Reading.store(value);
+        }
+        return *value;
+    }
+
+    inline void Release() {
+        m_Reading.store(nullptr, std::memory_order_release);
+    }
+
+    /**
+     * @brief Writer: the current version, to build the next one from.
+     */
+    const T& Current() const {
+        return *m_Current.load();
+    }
+
+    /**
+     * @brief Writer: make @p value the current version and free the previous one once the
+     *  reader left it.
+     */
+    void Publish(T value) {
+        const T* previous = m_Current.exchange(new T(std::move(value)));
+        while (m_Reading.load() == previous) {
+            std::this_thread::yield();
+        }
+        delete previous;
+    }
+
+   private:
+    std::atomic<const T*> m_Current;
+    std::atomic<const T*> m_Reading = nullptr;
+};
+
+}  // namespace riosession
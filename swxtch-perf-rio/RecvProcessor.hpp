@@ -0,0 +1,120 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include "GroupStats.hpp"
+#include "Histogram.hpp"
+#include "RcuValue.hpp"
+#include "RecvSlot.hpp"
+#include "StageProbes.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr DWORD MAX_RIO_RESULTS = 1000;  // Completions dequeued at once
+
+/**
+ * @brief Stats policy of RecvProcessor: per stream sequence accounting, see UpdateRxStats.
+ */
+struct SequenceStats {
+    static inline void Update(McGroupStats_t& stats,
+                              const size_t pktSize,
+                              const ProtocolHeader_t* pHdr) {
+        UpdateRxStats(stats, pktSize, pHdr);
+    }
+};
+
+/**
+ * @brief Per completion work of the consumer, independent of where the completions come from:
+ *  RioConsumer feeds it the batches dequeued from its RIO CQ, MockTransport runs feed it
+ *  synthetic ones at memory speed. Reposting is left to the caller's @p repost(result), with
+ *  the completion, whose request context holds the slot index in its low 32 bits, the rest is
+ *  the transport's; a reflector sends the datagram back instead.
+ *  Streams are looked up in the StreamTable current when the batch starts, so streams can be
+ *  added while it runs; packets of a stream that is not in it are counted as other packets.
+ *  The statistics are a compile-time policy, so the whole per packet path can be inlined.
+ */
+template <typename Stats = SequenceStats>
+class RecvProcessor {
+   public:
+    RecvProcessor() = default;
+    RecvProcessor(const RecvSlotLayout_t& slot,
+                  char* ring,
+                  RcuValue<StreamTable>* streams,
+                  LatencyHistogram* latency,
+                  StageProfile* stages = nullptr)
+        : m_Slot(slot),
+          m_Ring(ring),
+          m_Streams(streams),
+          m_Latency(latency),
+          m_Stages(stages) {
+    }
+
+    /**
+     * @brief Account @p numResults completions and repost their slots.
+     *
+     * @param batchTime Clock read once for the batch, 0 to not record latency
+     */
+    template <typename Repost>
+    inline void Process(const RIORESULT* results,
+                        ULONG numResults,
+                        uint64_t batchTime,
+                        Repost&& repost) {
+        uint64_t tsc = StageProfile::Now();
+        const StreamTable& streams = m_Streams->Acquire();
+        for (ULONG i = 0; i < numResults; ++i) {
+            auto slot = static_cast<ULONG>(results[i].RequestContext);
+            auto addr = m_Slot.Addr(m_Ring, slot);
+            McGroupStats_t* stats = results[i].BytesTransferred == m_Slot.DataSize
+                                        ? streams.Find(MakeStreamKey(addr->Ipv4.sin_addr.s_addr,
+                                                                     addr->Ipv4.sin_port))
+                                        : nullptr;
+            if (stats != nullptr) {
+                m_Packets++;
+                auto pHeader = reinterpret_cast<ProtocolHeader_t*>(m_Slot.Data(m_Ring, slot));
+                Stats::Update(*stats, m_Slot.DataSize, pHeader);
+                if (batchTime != 0) {
+                    m_Latency->Record(batchTime > pHeader->Timestamp
+                                          ? batchTime - pHeader->Timestamp
+                                          : 0);
+                }
+            } else {
+                m_OtherPackets++;
+            }
+            if (m_Stages) {
+                m_Stages->Mark(Stage::Process, tsc);
+            }
+            // Other packets are reposted too, otherwise each one would permanently
+            // shrink the ring
+            repost(results[i]);
+            if (m_Stages) {
+                m_Stages->Mark(Stage::Post, tsc);
+            }
+        }
+        m_Streams->Release();
+    }
+
+    /**
+     * @brief Histogram the next batches record their latency into.
+     */
+    void SetLatency(LatencyHistogram* latency) {
+        m_Latency = latency;
+    }
+
+    uint64_t Packets() const {
+        return m_Packets;
+    }
+    uint64_t OtherPackets() const {
+        return m_OtherPackets;
+    }
+
+   private:
+    RecvSlotLayout_t m_Slot;
+    char* m_Ring = nullptr;
+    RcuValue<StreamTable>* m_Streams = nullptr;
+    LatencyHistogram* m_Latency = nullptr;
+    StageProfile* m_Stages = nullptr;
+    uint64_t m_Packets = 0;
+    uint64_t m_OtherPackets = 0;
+};
+
+}  // namespace riosession
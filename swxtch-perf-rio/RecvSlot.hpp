@@ -0,0 +1,41 @@
+#pragma once
+// clang-format off
+#include <stddef.h>
+#include "RioCompat.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr DWORD ADDR_SIZE = sizeof(SOCKADDR_INET);
+constexpr DWORD CACHE_LINE_SIZE = 64;
+
+/**
+ * @brief Layout of one receive slot in the registered receive buffer.
+ *  The payload and the local (multicast group, or unicast) address written by RIO for the same
+ *  datagram share the slot, so processing a completion touches adjacent cache lines only:
+ *
+ *  | payload (DataSize) | pad to 4 | SOCKADDR_INET | pad to CACHE_LINE_SIZE |
+ *
+ *  With the default 100 bytes payload a slot is exactly two cache lines.
+ */
+struct RecvSlotLayout_t {
+    DWORD DataSize = 0;
+    DWORD AddrOffset = 0;
+    DWORD Stride = 0;
+
+    RecvSlotLayout_t() = default;
+    explicit RecvSlotLayout_t(DWORD dataSize)
+        : DataSize(dataSize),
+          AddrOffset((dataSize + 3) & ~3UL),
+          Stride((AddrOffset + ADDR_SIZE + CACHE_LINE_SIZE - 1) & ~(CACHE_LINE_SIZE - 1)) {
+    }
+
+    char* Data(char* base, ULONG slot) const {
+        return base + static_cast<size_t>(slot) * Stride;
+    }
+    SOCKADDR_INET* Addr(char* base, ULONG slot) const {
+        return reinterpret_cast<SOCKADDR_INET*>(Data(base, slot) + AddrOffset);
+    }
+};
+
+}  // namespace riosession
@@ -0,0 +1,167 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <stdio.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <string>
+#include "RioCompat.hpp"
+// clang-format on
+
+namespace riosession {
+
+/**
+ * @brief Counters of the consumer dequeues, written by the hot thread and read by the report
+ *  thread. Single writer: the hot thread updates with relaxed load/store, no locked instruction.
+ */
+struct RecvTelemetrySnapshot_t {
+    static constexpr size_t BATCH_BUCKETS = 12;  // empty, 1, 2-3, 4-7 ... 512-999, full
+
+    std::array<uint64_t, BATCH_BUCKETS> Batches{};
+    uint64_t Completions = 0;
+    uint64_t Overruns = 0;
+
+    uint64_t Dequeues() const {
+        uint64_t dequeues = 0;
+        for (auto batches : Batches) {
+            dequeues += batches;
+        }
+        return dequeues;
+    }
+
+    RecvTelemetrySnapshot_t operator-(const RecvTelemetrySnapshot_t& previous) const {
+        RecvTelemetrySnapshot_t delta;
+        for (size_t i = 0; i < BATCH_BUCKETS; i++) {
+            delta.Batches[i] = Batches[i] - previous.Batches[i];
+        }
+        delta.Completions = Completions - previous.Completions;
+        delta.Overruns = Overruns - previous.Overruns;
+        return delta;
+    }
+};
+
+/**
+ * @brief How full the dequeued batches are and how close the posted receives came to running
+ *  dry.
+ *
+ *  Batch sizes go to power of two buckets, with empty and full (maxResults) batches apart: many
+ *  empty or tiny batches mean an idle consumer, mostly full ones a CPU bound consumer.
+ *
+ *  Each dequeue also gives the receives outstanding at that time: those posted, the ring minus
+ *  the slots the loop still holds, minus the completions just dequeued, which are not reposted
+ *  yet. A partial batch emptied the CQ, so the count is exact; after a full one more
+ *  completions may be waiting, so it is the most that can have been outstanding. The loop
+ *  reposts a batch before its next dequeue, so back to back full batches do not add up. A
+ *  batch that completed every posted receive is an overrun: the ring ran dry and the stack
+ *  dropped whatever arrived until the repost.
+ */
+class RecvTelemetry {
+   public:
+    static constexpr size_t BATCH_BUCKETS = RecvTelemetrySnapshot_t::BATCH_BUCKETS;
+
+    void Init(ULONG ringSize, ULONG maxResults) {
+        m_RingSize = ringSize;
+        m_MaxResults = maxResults;
+        m_MinOutstanding = ringSize;
+        m_PeriodMinOutstanding = ringSize;
+    }
+
+    /**
+     * @brief Account one dequeue of @p numResults completions. Hot thread only.
+     *
+     * @param held Slots of the ring the loop has not reposted yet, from earlier batches
+     */
+    inline void OnDequeue(ULONG numResults, ULONG held = 0) {
+        Bump(m_Batches[Bucket(numResults)], 1);
+        if (numResults == 0) {
+            return;
+        }
+        Bump(m_Completions, numResults);
+        const uint64_t posted = m_RingSize - std::min(held, m_RingSize);
+        const uint64_t outstanding = posted - std::min<uint64_t>(numResults, posted);
+        if (outstanding < m_MinOutstanding.load(std::memory_order_relaxed)) {
+            m_MinOutstanding.store(outstanding, std::memory_order_relaxed);
+        }
+        if (outstanding < m_PeriodMinOutstanding.load(std::memory_order_relaxed)) {
+            m_PeriodMinOutstanding.store(outstanding, std::memory_order_relaxed);
+        }
+        if (outstanding == 0) {
+            Bump(m_Overruns, 1);
+        }
+    }
+
+    RecvTelemetrySnapshot_t Snapshot() const {
+        RecvTelemetrySnapshot_t snapshot;
+        for (size_t i = 0; i < BATCH_BUCKETS; i++) {
+            snapshot.Batches[i] = m_Batches[i].load(std::memory_order_relaxed);
+        }
+        snapshot.Completions = m_Completions.load(std::memory_order_relaxed);
+        snapshot.Overruns = m_Overruns.load(std::memory_order_relaxed);
+        return snapshot;
+    }
+
+    /**
+     * @brief Fewest receives outstanding since the start.
+     */
+    uint64_t MinOutstanding() const {
+        return m_MinOutstanding.load();
+    }
+
+    /**
+     * @brief Fewest receives outstanding since the previous call, for the period reports. A
+     *  minimum reached while it is reset may be lost, which is fine for a report.
+     */
+    uint64_t TakePeriodMinOutstanding() {
+        return m_PeriodMinOutstanding.exchange(m_RingSize);
+    }
+
+    ULONG RingSize() const {
+        return m_RingSize;
+    }
+
+    /**
+     * @brief Label of a batch size bucket, "2-3" for bucket 2.
+     */
+    std::string BucketLabel(size_t bucket) const {
+        if (bucket == 0) {
+            return "empty";
+        }
+        if (bucket == BATCH_BUCKETS - 1) {
+            return "full";
+        }
+        const uint64_t low = 1ULL << (bucket - 1);
+        const uint64_t high = std::min<uint64_t>((1ULL << bucket) - 1, m_MaxResults - 1);
+        return low == high ? std::to_string(low)
+                           : std::to_string(low) + "-" + std::to_string(high);
+    }
+
+   private:
+    static inline void Bump(std::atomic<uint64_t>& counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    inline size_t Bucket(ULONG numResults) const {
+        if (numResults == 0) {
+            return 0;
+        }
+        if (numResults >= m_MaxResults) {
+            return BATCH_BUCKETS - 1;
+        }
+        size_t bucket = 1;
+        while ((numResults >>= 1) != 0 && bucket < BATCH_BUCKETS - 2) {
+            bucket++;
+        }
+        return bucket;
+    }
+
+    ULONG m_RingSize = 1;
+    ULONG m_MaxResults = 1;
+    std::array<std::atomic<uint64_t>, BATCH_BUCKETS> m_Batches{};
+    std::atomic<uint64_t> m_Completions = 0;
+    std::atomic<uint64_t> m_Overruns = 0;
+    std::atomic<uint64_t> m_MinOutstanding = 1;
+    std::atomic<uint64_t> m_PeriodMinOutstanding = 1;
+};
+
+}  // namespace riosession
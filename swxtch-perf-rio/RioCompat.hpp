@@ -0,0 +1,34 @@
+#pragma once
+// clang-format off
+#if defined _WINDOWS
+    #include "stdafx.h"
+#else
+    #include <stdint.h>
+    #include <netinet/in.h>
+#endif
+// clang-format on
+
+/**
+ * Minimal stand-ins for the Windows/RIO types used by the portable hot path headers
+ * (GroupStats.hpp, RecvSlot.hpp), so they also build on Linux for the benchmarks.
+ * On Windows the real definitions are used.
+ */
+#if !defined _WINDOWS
+using DWORD = uint32_t;
+using LONG = int32_t;
+using ULONG = uint32_t;
+using ULONGLONG = uint64_t;
+
+struct RIORESULT {
+    LONG Status;
+    ULONG BytesTransferred;
+    ULONGLONG SocketContext;
+    ULONGLONG RequestContext;
+};
+
+union SOCKADDR_INET {
+    sockaddr_in Ipv4;
+    sockaddr_in6 Ipv6;
+    sa_family_t si_family;
+};
+#endif
@@ -2,50 +2,440 @@
 
 namespace riosession {
 RioConsumer::RioConsumer(args_t* args, volatile sig_atomic_t* signal) : RioSession(args, signal) {
-    BindSocket(args->McastPort, args->IfIndex);
-    JoinGroups(args->McastAddrStr);
-    m_MaxOutstandingReceive = MAX_PENDING_RECVS;
+    const bool reflect = m_Args->Command == REFLECTOR_COMMAND;
+    OpenGroupSockets();
+    // The ring is split evenly between the request queues of the sockets, over one CQ and one
+    // registered buffer
+    const ULONG sockets = static_cast<ULONG>(m_Sockets.size());
+    m_Slot = RecvSlotLayout_t(static_cast<DWORD>(m_Args->PayloadSize));
+    m_SocketRecvs = std::max((ComputeRecvRingSize() + sockets - 1) / sockets, MIN_SOCKET_RECVS);
+    // The registered buffer is sized by a DWORD, so big payloads cap the ring below its target
+    const auto maxSocketRecvs
+        = static_cast<ULONG>(MAX_REGISTERED_BUFFER / m_Slot.Stride / sockets);
+    if (m_SocketRecvs > maxSocketRecvs) {
+        printf("Receive ring capped at %lu slots to fit a %lu byte slot in one buffer\n",
+               maxSocketRecvs * sockets, m_Slot.Stride);
+        m_SocketRecvs = maxSocketRecvs;
+    }
+    m_MaxOutstandingReceive = m_SocketRecvs * sockets;
     m_MaxReceiveDataBuffers = 1;
-    m_MaxOutstandingSend = 0;
+    m_MaxOutstandingSend = reflect ? m_SocketRecvs : 0;  // A reflector sends every slot back
     m_MaxSendDataBuffers = 1;
-    m_RioBuffDescr = std::make_unique<RIO_BUF[]>(m_MaxOutstandingReceive);
     InitializeRIO();
     CreateCompletionQueue(static_cast<DWORD>(m_MaxOutstandingReceive));
-    CreateRequestQueue();
+    if (reflect) {
+        m_EchoQueue = CreatePolledCompletionQueue(static_cast<DWORD>(m_MaxOutstandingReceive));
+    }
+    std::vector<RIO_RQ> requestQueues;
+    for (auto socket : m_Sockets) {
+        requestQueues.push_back(CreateRequestQueue(socket, m_SocketRecvs, m_CompletionQueue,
+                                                   reflect ? m_EchoQueue : m_CompletionQueue));
+    }
+    m_RequestQueue = requestQueues.front();
+    // Payloads and addresses share one registered buffer, see RecvSlotLayout_t
     m_RioBuffPtr = AllocateAndRegisterBuffer(
-        EXPECTED_DATA_SIZE, static_cast<DWORD>(m_MaxOutstandingReceive), m_RioBuffId);
-    m_McAddrBuffPtr = AllocateAndRegisterBuffer(
-        ADDR_SIZE, static_cast<DWORD>(m_MaxOutstandingReceive), m_McAddrBuffId);
-    InitMcAddrDescriptors();
+        m_Slot.Stride, static_cast<DWORD>(m_MaxOutstandingReceive), m_RioBuffId, m_RioBuffSize);
+    if (reflect) {
+        // The sender of the datagram of each slot, where its echo goes
+        m_McAddrBuffPtr
+            = AllocateAndRegisterBuffer(ADDR_SIZE, static_cast<DWORD>(m_MaxOutstandingReceive),
+                                        m_McAddrBuffId, m_McAddrBuffSize);
+    }
+    std::cout << "Receive ring: " << m_MaxOutstandingReceive << " preposted receives of "
+              << m_Slot.Stride << " bytes (" << m_RioBuffSize / (1024 * 1024)
+              << " MB registered)";
+    if (sockets > 1) {
+        std::cout << ", " << m_SocketRecvs << " on each of the " << sockets << " sockets";
+    }
+    std::cout << std::endl;
+    if (reflect) {
+        m_Echo = std::make_unique<EchoRecycle>(m_RioFuncTable, &m_Transport, requestQueues,
+                                               m_EchoQueue, m_RioBuffId, m_McAddrBuffId, m_Slot);
+        std::cout << "Reflecting every datagram back to its sender" << std::endl;
+    }
+    m_Transport = RioRecvTransport(m_RioFuncTable, std::move(requestQueues), m_CompletionQueue,
+                                   m_RioBuffId, m_Slot,
+                                   reflect ? m_McAddrBuffId : RIO_INVALID_BUFFERID);
+    m_Processor = RecvProcessor<>(m_Slot, m_RioBuffPtr, &m_StreamTable, nullptr, &m_Stages);
+    m_Telemetry.Init(m_MaxOutstandingReceive, MAX_RIO_RESULTS);
+    if (m_Args->ChurnRate != CHURN_RATE_OFF) {
+        m_Churn = std::make_unique<GroupChurn>(
+            *m_Args, m_GroupStats,
+            [this](size_t group, size_t port, bool join) {
+                return ChangeMembership(group, port, join);
+            });
+    }
+    if (m_Args->Aggregator != AGGREGATOR_OFF) {
+        m_Publisher = std::make_unique<StatsPublisher>(m_Args->Aggregator, m_Args->AggregatorPort);
+        std::cout << "Pushing the statistics to " << m_Args->Aggregator << ":"
+                  << m_Args->AggregatorPort << " as " << m_Publisher->Receiver() << std::endl;
+    }
+}
+
+/**
+ * @brief Open the receive sockets: for each port, one socket per slice of --groups_per_socket
+ *  groups, which joins the groups of its slice only. Per socket membership limits and the
+ *  receives of a single RQ then do not bound the number of groups. The first socket is the
+ *  session's. Churned groups are left to GroupChurn. With --unicast each port has one socket,
+ *  bound to every local address and joining nothing: unicast datagrams to a port shared by
+ *  several sockets would go to one of them only. Datagrams to other addresses than
+ *  --mcast_ip are counted as other packets.
+ */
+void RioConsumer::OpenGroupSockets() {
+    const Ipv4Vect& groups = m_Args->McastAddrStr;
+    const size_t perSocket = m_Args->Unicast ? groups.size() : m_Args->GroupsPerSocket;
+    const size_t slices = (groups.size() + perSocket - 1) / perSocket;
+    const size_t joined = groups.size() - GroupChurn::ChurnedGroups(*m_Args);
+    for (size_t group = 0; group < groups.size(); group++) {
+        if (group < joined) {
+            m_GroupSlices[groups[group].ipNetOrder()] = group / perSocket;
+        }
+    }
+    m_SliceGroups.assign(slices, perSocket);
+    if (groups.size() % perSocket != 0) {
+        m_SliceGroups.back() = groups.size() % perSocket;
+    }
+    for (const auto port : m_Args->McastPorts) {
+        for (size_t slice = 0; slice < slices; slice++) {
+            SOCKET socket
+                = m_Sockets.empty() ? m_SocketHandle : OpenSocket(WSA_FLAG_REGISTERED_IO);
+            // "Share" socket address: the slices of a port are bound to the same one
+            int sockOpt = 1;
+            setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char*>(&sockOpt),
+                       sizeof(int));
+            BindSocket(socket, port, m_Args->Unicast ? "" : m_Args->IfIndex);
+            const size_t first = std::min(slice * perSocket, joined);
+            const size_t last = std::min(first + perSocket, joined);
+            if (!m_Args->Unicast) {
+                JoinGroups(socket, Ipv4Vect(groups.begin() + first, groups.begin() + last));
+            }
+            m_Sockets.push_back(socket);
+        }
+    }
+    if (m_Sockets.size() > 1) {
+        std::cout << "Receive sockets: " << m_Sockets.size() << " (" << m_Args->McastPorts.size()
+                  << " ports x " << slices << " slices of at most " << perSocket << " groups)"
+                  << std::endl;
+    }
+}
+
+/**
+ * @brief Number of receives to prepost, which is also the size of the CQ.
+ *  --recv_ring wins. Otherwise the ring holds --burst_ms of traffic at --expected_pps,
+ *  so a consumer stalled for that long does not drop. Without an expected rate the
+ *  maximum is used.
+ * @return ULONG
+ */
+ULONG RioConsumer::ComputeRecvRingSize() const {
+    uint64_t ringSize = MAX_PENDING_RECVS;
+    if (m_Args->RecvRing != 0) {
+        ringSize = m_Args->RecvRing;
+    } else if (m_Args->ExpectedPacketRate != 0) {
+        ringSize = m_Args->ExpectedPacketRate * m_Args->BurstMs / 1000;
+    }
+    ringSize = std::clamp<uint64_t>(ringSize, MIN_PENDING_RECVS, MAX_PENDING_RECVS);
+    return static_cast<ULONG>(ringSize);
+}
+
+/**
+ * @brief Print how the receive ring and the dequeues were used over the whole run, see
+ *  RecvTelemetry. A minimum outstanding close to 0, or any overrun, means the ring is
+ *  undersized; one that never goes far below the ring size means it could be smaller.
+ */
+void RioConsumer::PrintRingUsage() const {
+    const auto totals = m_Telemetry.Snapshot();
+    const uint64_t minOutstanding = m_Telemetry.MinOutstanding();
+    printf("\tReceive ring: %lu receives, min outstanding: %llu (%.1f%%), overruns: %llu\n",
+           m_MaxOutstandingReceive, minOutstanding,
+           100.0 * minOutstanding / m_MaxOutstandingReceive, totals.Overruns);
+    const uint64_t dequeues = totals.Dequeues();
+    printf("\tDequeues: %llu, mean batch %.1f. Batch sizes:", dequeues,
+           dequeues ? static_cast<double>(totals.Completions) / dequeues : 0.0);
+    for (size_t i = 0; i < RecvTelemetry::BATCH_BUCKETS; i++) {
+        if (totals.Batches[i] != 0) {
+            printf(" %s: %.1f%%", m_Telemetry.BucketLabel(i).c_str(),
+                   100.0 * totals.Batches[i] / dequeues);
+        }
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Dequeue line under a report row: batch fill, receives left and overruns of the period,
+ *  and its latency quantiles when measured.
+ */
+void RioConsumer::PrintBatchRow(const IntervalSample_t& sample) const {
+    printf("|   batch mean %7.1f, empty %5.1f%%, full %5.1f%% | min outstanding %8llu (%5.1f%%) "
+           "| overruns %llu",
+           sample.BatchMean, sample.EmptyBatchPct, sample.FullBatchPct, sample.MinOutstanding,
+           100.0 * sample.MinOutstanding / m_MaxOutstandingReceive, sample.Overruns);
+    if (m_Args->MeasureLatency) {
+        printf(" | latency us p50 %.1f, p99 %.1f, max %.1f", sample.LatencyP50Ns / 1e3,
+               sample.LatencyP99Ns / 1e3, sample.LatencyMaxNs / 1e3);
+    }
+    printf("\n");
+}
+
+/**
+ * @brief Print what GroupChurn measured: membership call and first packet times, the loss of
+ *  the existing groups, and the first join of each churned stream (CHURN_LIST_MAX at most).
+ */
+void RioConsumer::PrintChurn(const ChurnReport_t& churn) const {
+    auto printTimes = [](const char* name, const LatencyHistogram& times, double unitNs) {
+        printf("\t%s: %llu, min %.1f, p50 %.1f, p99 %.1f, max %.1f\n", name, times.Count(),
+               times.Min() / unitNs, times.Percentile(50) / unitNs,
+               times.Percentile(99) / unitNs, times.Max() / unitNs);
+    };
+    printf("\tChurn: %zu groups churned next to %zu existing ones. %llu joins, %llu leaves, "
+           "%llu failed calls\n",
+           churn.ChurnedGroups, churn.ExistingGroups, churn.Joins, churn.Leaves, churn.Failed);
+    printTimes("Join calls (us)", churn.JoinCall, 1e3);
+    printTimes("Leave calls (us)", churn.LeaveCall, 1e3);
+    printTimes("First packet after the first join (ms)", churn.FirstPacket, 1e6);
+    printTimes("First packet after a rejoin (ms)", churn.RejoinPacket, 1e6);
+    printf("\tJoins without a packet within %llu s: %llu, left before their first packet: "
+           "%llu\n",
+           static_cast<uint64_t>(CHURN_FIRST_PACKET_TIMEOUT.count()), churn.NoFirstPacket,
+           churn.LeftEarly);
+    printf("\tExisting groups lost %llu packets. Per operation: p50 %llu, p99 %llu, max %llu\n",
+           churn.ExistingLost, churn.ExistingLoss.Percentile(50),
+           churn.ExistingLoss.Percentile(99), churn.ExistingLoss.Max());
+
+    if (churn.FirstJoins.empty()) {
+        return;
+    }
+    printf("\n  Group:Port           Join call (us)  First packet (ms)\n");
+    const size_t listed = std::min(churn.FirstJoins.size(), CHURN_LIST_MAX);
+    for (size_t i = 0; i < listed; i++) {
+        const auto& join = churn.FirstJoins[i];
+        printf("  %-21s %14.1f  ", StreamName(join.Key).c_str(), join.JoinCallNs / 1e3);
+        if (join.FirstPacketNs != 0) {
+            printf("%17.3f\n", join.FirstPacketNs / 1e6);
+        } else {
+            printf("%17s\n", "none");
+        }
+    }
+    if (listed < churn.FirstJoins.size()) {
+        printf("  ... %zu more\n", churn.FirstJoins.size() - listed);
+    }
 }
 
 /**
  * @brief Join an specific multicast group. It can be performed several times to join
  * a series of multicast groups on the same socket.
+ * @param socket
  * @param grpaddr Multicast Group Address
  * @param iaddr Local Interface address to use
  * @return int
  */
-int RioConsumer::JoinGroup(UINT32 grpaddr, UINT32 iaddr) {
-    // "Share" socket address.
-    int sockOpt = 1;
-    setsockopt(m_SocketHandle, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<char*>(&sockOpt),
-               sizeof(int));
+int RioConsumer::JoinGroup(SOCKET socket, UINT32 grpaddr, UINT32 iaddr) {
     // Join the group
     struct ip_mreq imr;
     imr.imr_multiaddr.s_addr = grpaddr;
     imr.imr_interface.s_addr = iaddr;
-    return setsockopt(m_SocketHandle, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&imr, sizeof(imr));
+    return setsockopt(socket, IPPROTO_IP, IP_ADD_MEMBERSHIP, (char*)&imr, sizeof(imr));
 }
 
 /**
- * @brief Join "n" multicast groups by iterating over all addresses
+ * @brief Leave a multicast group joined with JoinGroup.
+ * @param socket
+ * @param grpaddr Multicast Group Address
+ * @param iaddr Local Interface address it was joined on
+ * @return int
+ */
+int RioConsumer::LeaveGroup(SOCKET socket, UINT32 grpaddr, UINT32 iaddr) {
+    struct ip_mreq imr;
+    imr.imr_multiaddr.s_addr = grpaddr;
+    imr.imr_interface.s_addr = iaddr;
+    return setsockopt(socket, IPPROTO_IP, IP_DROP_MEMBERSHIP, (char*)&imr, sizeof(imr));
+}
+
+/**
+ * @brief Join or leave the group of index @p group in --mcast_ip on the socket that holds it
+ *  for the port of index @p port, see OpenGroupSockets. Called by GroupChurn.
+ * @return int setsockopt result
+ */
+int RioConsumer::ChangeMembership(size_t group, size_t port, bool join) {
+    const size_t perSocket = m_Args->GroupsPerSocket;
+    const size_t slices = (m_Args->McastAddrStr.size() + perSocket - 1) / perSocket;
+    SOCKET socket = m_Sockets[port * slices + group / perSocket];
+    const UINT32 grpaddr = m_Args->McastAddrStr[group].ipNetOrder();
+    const UINT32 iaddr = inet_addr(m_Args->IfIndex.c_str());
+    return join ? JoinGroup(socket, grpaddr, iaddr) : LeaveGroup(socket, grpaddr, iaddr);
+}
+
+/**
+ * @brief Live requests: join or leave groups, a --mcast_ip style address or range, on every
+ *  port, and list the joined groups.
+ */
+std::string RioConsumer::Control(const std::vector<std::string>& words) {
+    const std::string& request = words.front();
+    if ((request == "join" || request == "leave") && words.size() == 2) {
+        if (m_Args->Unicast) {
+            return "Unicast: every datagram to a port is received, there is nothing to "
+                   + request;
+        }
+        const Ipv4Vect groups = ParseGroups(words[1]);
+        return request == "join" ? JoinLive(groups) : LeaveLive(groups);
+    }
+    if (request == "groups" && words.size() == 1) {
+        return ListGroups();
+    }
+    return RioSession::Control(words);
+}
+
+std::string RioConsumer::ControlHelp() const {
+    return "join <groups>, leave <groups>, groups";
+}
+
+bool RioConsumer::IsChurned(const swxtch::net::Ipv4Addr_t& group) const {
+    const Ipv4Vect& groups = m_Args->McastAddrStr;
+    const size_t churned = GroupChurn::ChurnedGroups(*m_Args);
+    return std::any_of(groups.end() - churned, groups.end(), [&](const auto& g) {
+        return g.ipNetOrder() == group.ipNetOrder();
+    });
+}
+
+/**
+ * @brief Join @p groups on the running session. Each group goes to the first slice of sockets
+ *  with fewer than --groups_per_socket groups and is joined on the socket of every port. Its
+ *  statistics are added beforehand (see AddStreams), so its first packets are counted and
+ *  reception never stops for the groups already joined. Churned groups are left to GroupChurn.
+ *
+ * @return std::string The reply
+ */
+std::string RioConsumer::JoinLive(const Ipv4Vect& groups) {
+    Ipv4Vect toJoin;
+    size_t skipped = 0;
+    for (const auto group : groups) {
+        if (m_GroupSlices.count(group.ipNetOrder()) != 0 || IsChurned(group)) {
+            skipped++;
+        } else {
+            toJoin.push_back(group);
+        }
+    }
+    AddStreams(toJoin, m_Args->McastPorts);
+
+    const UINT32 iaddr = inet_addr(m_Args->IfIndex.c_str());
+    const size_t slices = m_SliceGroups.size();
+    const size_t ports = m_Args->McastPorts.size();
+    size_t joined = 0;
+    size_t failed = 0;
+    std::string firstError;
+    for (const auto group : toJoin) {
+        auto slice = std::find_if(m_SliceGroups.begin(), m_SliceGroups.end(),
+                                  [this](size_t n) { return n < m_Args->GroupsPerSocket; });
+        if (slice == m_SliceGroups.end()) {
+            failed += toJoin.size() - joined - failed;
+            if (firstError.empty()) {
+                firstError = "every socket has --groups_per_socket groups";
+            }
+            break;
+        }
+        const size_t s = slice - m_SliceGroups.begin();
+        for (size_t p = 0; p < ports; p++) {
+            MarkMembership(group.ipNetOrder(), p, true);
+        }
+        size_t port = 0;
+        while (port < ports
+               && JoinGroup(m_Sockets[port * slices + s], group.ipNetOrder(), iaddr) == 0) {
+            port++;
+        }
+        if (port < ports) {
+            if (firstError.empty()) {
+                firstError = group.str() + " error " + std::to_string(::WSAGetLastError());
+            }
+            while (port-- > 0) {
+                LeaveGroup(m_Sockets[port * slices + s], group.ipNetOrder(), iaddr);
+            }
+            failed++;
+            continue;
+        }
+        m_GroupSlices[group.ipNetOrder()] = s;
+        (*slice)++;
+        joined++;
+    }
+    std::string reply = "Joined " + std::to_string(joined) + " groups, " + std::to_string(skipped)
+                        + " already joined, " + std::to_string(failed) + " failed";
+    return firstError.empty() ? reply : reply + " (" + firstError + ")";
+}
+
+/**
+ * @brief Mark the stream of @p group on the port of index @p port left, or @p joined again:
+ *  the receive path then ignores it, or restarts its sequence from its next packet, so the
+ *  packets sent in between are not drops (see UpdateRxStats).
+ */
+void RioConsumer::MarkMembership(uint32_t group, size_t port, bool joined) {
+    std::lock_guard<std::mutex> lock(m_GroupStatsLock);
+    auto stats = m_GroupStats.find(MakeStreamKey(group, htons(m_Args->McastPorts[port])));
+    if (stats == m_GroupStats.end()) {
+        return;
+    }
+    if (joined) {
+        stats->second.Rejoined.store(true, std::memory_order_relaxed);
+        stats->second.Left.store(false, std::memory_order_release);
+    } else {
+        stats->second.Left.store(true, std::memory_order_release);
+    }
+}
+
+/**
+ * @brief Leave @p groups on every port. Their statistics stay, for the final table and for a
+ *  later join, which resumes them without counting the packets missed meanwhile.
+ *
+ * @return std::string The reply
+ */
+std::string RioConsumer::LeaveLive(const Ipv4Vect& groups) {
+    const UINT32 iaddr = inet_addr(m_Args->IfIndex.c_str());
+    const size_t slices = m_SliceGroups.size();
+    size_t left = 0;
+    size_t failed = 0;
+    for (const auto group : groups) {
+        auto joined = m_GroupSlices.find(group.ipNetOrder());
+        if (joined == m_GroupSlices.end()) {
+            continue;
+        }
+        const size_t s = joined->second;
+        for (size_t port = 0; port < m_Args->McastPorts.size(); port++) {
+            if (LeaveGroup(m_Sockets[port * slices + s], group.ipNetOrder(), iaddr) != 0) {
+                failed++;
+            } else {
+                MarkMembership(group.ipNetOrder(), port, false);
+            }
+        }
+        m_SliceGroups[s]--;
+        m_GroupSlices.erase(joined);
+        left++;
+    }
+    return "Left " + std::to_string(left) + " groups, " + std::to_string(groups.size() - left)
+           + " not joined, " + std::to_string(failed) + " failed calls";
+}
+
+std::string RioConsumer::ListGroups() const {
+    std::string reply = std::to_string(m_GroupSlices.size()) + " groups joined";
+    size_t listed = 0;
+    for (const auto& [group, slice] : m_GroupSlices) {
+        if (listed++ == CONTROL_LIST_MAX) {
+            reply += " ...";
+            break;
+        }
+        char inetspace[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, &group, inetspace, INET_ADDRSTRLEN);
+        reply += std::string(listed == 1 ? ": " : ", ") + inetspace;
+    }
+    return reply;
+}
+
+/**
+ * @brief Join "n" multicast groups on @p socket by iterating over all addresses
  * configured by the user.
+ * @param socket
  * @param mcastAddrs
  */
-void RioConsumer::JoinGroups(Ipv4Vect mcastAddrs) {
+void RioConsumer::JoinGroups(SOCKET socket, const Ipv4Vect& mcastAddrs) {
     for (const auto mcAddr : mcastAddrs) {
-        auto r = JoinGroup(inet_addr(mcAddr.str().c_str()), inet_addr(m_Args->IfIndex.c_str()));
+        auto r = JoinGroup(socket, inet_addr(mcAddr.str().c_str()),
+                           inet_addr(m_Args->IfIndex.c_str()));
         if (r < 0) {
             utilities::ErrorExit("setsockopt", r);
         }
@@ -53,153 +443,143 @@ void RioConsumer::JoinGroups(Ipv4Vect mcastAddrs) {
 }
 
 /**
- * @brief Init the Multicast Address Descriptors
- *  Each descriptor will point to a position of the Address Buffer where
- *  SOCKADDR_INET information will be stored on each received packet.
+ * @brief Post a receive in every slot using RIO: the slots of each socket are contiguous, a
+ *  completed slot is reposted to the same socket.
  */
-void RioConsumer::InitMcAddrDescriptors() {
-    ULONG offset = 0;
-    m_McAddrDescr = std::make_unique<RIO_BUF[]>(m_MaxOutstandingReceive);
-    for (DWORD i = 0; i < m_MaxOutstandingReceive; i++) {
-        m_McAddrDescr[i].BufferId = m_McAddrBuffId;
-        m_McAddrDescr[i].Offset = offset;
-        m_McAddrDescr[i].Length = ADDR_SIZE;
-        offset += ADDR_SIZE;
+void RioConsumer::PostFirstRecvs() {
+    for (ULONG socket = 0; socket < m_Sockets.size(); socket++) {
+        for (ULONG slot = socket * m_SocketRecvs; slot < (socket + 1) * m_SocketRecvs; ++slot) {
+            m_Transport.PostRecv(slot, socket);
+        }
     }
 }
 
 /**
- * @brief Post a number of @param totalMessages receives using RIO.
- * Each RIO_BUF descriptor tells where to store each packet on the buffer.
- *
- * @param totalMessages
+ * @brief Close the other sockets, their request queues go with them, then the session's.
  */
-void RioConsumer::PostFirstRecvs(DWORD totalMessages) {
-    DWORD offset = 0;
-    DWORD recvFlags = 0;
-    for (DWORD i = 0; i < totalMessages; ++i) {
-        // Fill Descriptors
-        m_RioBuffDescr[i].BufferId = m_RioBuffId;
-        m_RioBuffDescr[i].Offset = offset;
-        m_RioBuffDescr[i].Length = EXPECTED_DATA_SIZE;
-
-        offset += EXPECTED_DATA_SIZE;
-        if (!m_RioFuncTable.RIOReceiveEx(m_RequestQueue, &m_RioBuffDescr[i], 1, &m_McAddrDescr[i],
-                                         NULL, NULL, NULL, recvFlags, &m_RioBuffDescr[i])) {
-            utilities::ErrorExit("RIOReceive");
+void RioConsumer::CleanUpRIO() {
+    for (size_t i = 1; i < m_Sockets.size(); i++) {
+        if (SOCKET_ERROR == ::closesocket(m_Sockets[i])) {
+            utilities::ErrorExit("Error Closing Socket");
         }
     }
+    m_Sockets.resize(1);
+    RioSession::CleanUpRIO();
 }
 
 void RioConsumer::Start() {
-    DWORD numberOfBytes = 0;
-    ULONG_PTR completionKey = 0;
-    OVERLAPPED* pOverlapped = 0;
-    DWORD recvFlags = 0;
-    ULONGLONG packetCounter = 0;
-    ULONGLONG otherPacketCounter = 0;
-    RIORESULT results[MAX_RIO_RESULTS];
-    ULONG mcAddrDescrIndex = 0;
-    BOOL shouldNotify = true;
-    
     m_Timing.setStart(); //set start time because report thread will crash if not
-    m_ReportThread = std::make_unique<std::thread>(&RioConsumer::ReportWorker, this);
-    PostFirstRecvs(static_cast<DWORD>(m_MaxOutstandingReceive));
+    StartPrinter();
+    m_ReportThread = std::make_unique<std::thread>(&RioConsumer::SampleWorker, this);
+    PostFirstRecvs();
+    StartControl();
+    if (m_Churn) {
+        m_Churn->Start();
+    }
 
-    while (ShouldStop()) {
-        if (shouldNotify)
-            NotifyCompletionQueue();
+    if (m_Echo) {
+        Run(*m_Echo);
+    } else {
+        RepostRecycle repost(&m_Transport);
+        Run(repost);
+    }
+
+    if (m_Churn) {
+        m_Churn->Stop();
+    }
+    StopControl();
+    JoinThread(m_ReportThread);
+    StopPrinter();
+    m_Latency.Merge(m_IntervalLatency.Take());
+    PrintTimings(m_Processor.Packets(), m_Processor.OtherPackets());
+    PrintRingUsage();
+    if (m_Echo) {
+        printf("\tEchoes sent: %llu\n", m_Echo->Echoes());
+    }
+    if (m_Args->MeasureLatency) {
+        PrintLatency(m_Latency);
+    }
+    if (m_Churn) {
+        PrintChurn(m_Churn->Report());
+    }
+    m_Stages.PrintTotals("Consumer");
+    GroupStatsPrint();
+}
 
-        if (!::GetQueuedCompletionStatus(m_hIOCP, &numberOfBytes, &completionKey, &pOverlapped,
-                                         100)) {
-            shouldNotify = false;
+/**
+ * @brief Run the receive loop with @p recycle and the completion strategy of the arguments.
+ *  Both are chosen once, each loop is compiled with its own inlined. A reflector always polls,
+ *  see EchoRecycle.
+ */
+template <typename Recycle>
+void RioConsumer::Run(Recycle& recycle) {
+    if (m_Args->BusyPoll || m_Echo) {
+        RunLoop(PollCompletion{}, recycle);
+    } else {
+        RunLoop(NotifyCompletion(m_RioFuncTable, m_CompletionQueue, m_hIOCP), recycle);
+    }
+}
+
+/**
+ * @brief The receive loop: wait as the completion strategy says, dequeue a batch, account it
+ *  and hand it to the recycle policy, which reposts it or, on a reflector, sends it back.
+ *  Transport, completion strategy, recycle policy and statistics are compile-time policies
+ *  (see RioPolicies.hpp), so there is no virtual call per packet.
+ */
+template <typename Completion, typename Recycle>
+void RioConsumer::RunLoop(Completion completion, Recycle& recycle) {
+    RIORESULT results[MAX_RIO_RESULTS];
+
+    while (ShouldStop()) {
+        uint64_t tsc = StageProfile::Now();
+        recycle.Reap();
+        if (completion.Notify()) {
+            m_Stages.Mark(Stage::Notify, tsc);
         }
+        completion.Wait();
+        m_Stages.Mark(Stage::Wait, tsc);
 
-        ULONG numResults
-            = m_RioFuncTable.RIODequeueCompletion(m_CompletionQueue, results, MAX_RIO_RESULTS);
+        ULONG numResults = m_Transport.Dequeue(results, MAX_RIO_RESULTS);
+        m_Stages.Mark(Stage::Dequeue, tsc);
 
+        if (RIO_CORRUPT_CQ == numResults) {
+            continue;
+        }
+        m_Telemetry.OnDequeue(numResults, recycle.Held());
         // If there is no pkts to read right now just loop around
-        if (0 == numResults || RIO_CORRUPT_CQ == numResults) {
+        if (0 == numResults) {
             continue;
         }
         if (m_TotalPkts == 0)
             m_Timing.setStart(); //overwrite start time
-
-        for (DWORD i = 0; i < numResults; ++i) {
-            auto pBuffer = reinterpret_cast<RIO_BUF*>(results[i].RequestContext);
-            m_TotalPkts++;  // atomic fetch add
-            if (results[i].BytesTransferred == EXPECTED_DATA_SIZE) {
-                packetCounter++;
-                auto nextAddr = &m_McAddrDescr[mcAddrDescrIndex % m_MaxOutstandingReceive];
-                auto mcastAddr
-                    = reinterpret_cast<SOCKADDR_INET*>(m_McAddrBuffPtr + nextAddr->Offset);
-                auto pHeader = reinterpret_cast<ProtocolHeader_t*>(m_RioBuffPtr + pBuffer->Offset);
-                GroupStatsUpdate(mcastAddr, EXPECTED_DATA_SIZE, pHeader);
-
-                // Start receiving again
-                if (!m_RioFuncTable.RIOReceiveEx(m_RequestQueue, pBuffer, 1, nextAddr, NULL, NULL,
-                                                 NULL, recvFlags, pBuffer)) {
-                    utilities::ErrorExit("RIOReceive");
-                }
-                mcAddrDescrIndex++;
-            } else {
-                otherPacketCounter++;
-            }
+        m_TotalPkts += numResults;
+        // One clock read per batch: a packet's latency includes its wait in the CQ
+        const uint64_t batchTime = m_Args->MeasureLatency ? utilities::get_unix_time() : 0;
+        if (batchTime != 0) {
+            m_Processor.SetLatency(&m_IntervalLatency.BeginBatch());
         }
-        shouldNotify = true;
-    }
-    JoinThread(m_ReportThread);
-    PrintTimings(packetCounter, otherPacketCounter);
-    GroupStatsPrint();
-}
-
-/**
- * @brief Update the statistics for an specific Multicast Group
- *
- * @param addr Stores a pointer the IPV4 address of the multicast group used as a key in the map
- * @param pktSize Stores the size of the received packet
- * @param pHdr Stores a pointer to the ProtocolHeader
- */
-void RioConsumer::GroupStatsUpdate(const SOCKADDR_INET* addr,
-                                   const size_t pktSize,
-                                   const ProtocolHeader_t* pHdr) {
-    uint32_t mcGroup = addr->Ipv4.sin_addr.s_addr;
-    McGroupStats_t& gmc = m_GroupStats[mcGroup];
-
-    if (pHdr->Seq == gmc.ExpectedSequence.load()) {
-        // The received sequence matches the expected one
-        gmc.ExpectedSequence++;
-        gmc.Sequence.store(pHdr->Seq);
-    } else if (pHdr->Seq > gmc.ExpectedSequence.load()) {
-        // If it's not the first packet then-->drops. Otherwise expected a new seq.
-        if (gmc.Packets.load() != 0)
-            gmc.RxDropped += pHdr->Seq - gmc.ExpectedSequence.load();
-        gmc.ExpectedSequence.store(pHdr->Seq + 1);
-        gmc.Sequence.store(pHdr->Seq);
-    } else {
-        // Out of order packets
-        if (gmc.RxDropped.load() > 0)
-            gmc.RxDropped--;
-        gmc.OutOfOrder++;
+        m_Processor.Process(results, numResults, batchTime, recycle);
+        if (batchTime != 0) {
+            m_IntervalLatency.EndBatch();
+        }
+        completion.Processed();
+        m_Stages.EndOfBatch("Consumer");
     }
-    gmc.Packets++;
-    gmc.Bytes.fetch_add(pktSize);
 }
 
 void RioConsumer::GroupStatsPrint() {
-    char inetspace[16];
     uint64_t totalPackets = 0;
     uint64_t totalBytes = 0;
     uint64_t totalOutOfSequence = 0;
     uint64_t totalDrops = 0;
 
-    std::cout << "\n  Group           Packets        Bytes      Last Seq   OutOfOrder    Drops"
-              << std::endl;
-    std::cout << "-----------------------------------------------------------------------------"
+    std::cout << "\n  Group:Port            Packets        Bytes      Last Seq   OutOfOrder"
+                 "    Drops"
               << std::endl;
+    std::cout << std::string(81, '-') << std::endl;
 
     for (auto const& [key, value] : m_GroupStats) {
-        std::cout << inet_ntop(AF_INET, &key, inetspace, INET_ADDRSTRLEN) << "\t" << std::dec
+        std::cout << std::left << std::setw(21) << StreamName(key) << std::right << std::dec
                   << std::setw(10) << value.Packets << "  " << std::setw(12) << value.Bytes << "  "
                   << std::setw(10) << value.Sequence << "  " << std::setw(10) << value.OutOfOrder
                   << "  " << std::setw(10) << value.RxDropped << std::endl;
@@ -209,11 +589,10 @@ void RioConsumer::GroupStatsPrint() {
         totalOutOfSequence += value.OutOfOrder;
         totalDrops += value.RxDropped;
     }
-    std::cout << "-----------------------------------------------------------------------------"
-              << std::endl;
-    std::cout << "Totals:"
-              << "\t\t" << std::setw(10) << totalPackets << "  " << std::setw(12) << totalBytes
-              << "    " << std::setw(20) << totalOutOfSequence << std::setw(12) << totalDrops
+    std::cout << std::string(81, '-') << std::endl;
+    std::cout << std::left << std::setw(21) << "Totals:" << std::right << std::setw(10)
+              << totalPackets << "  " << std::setw(12) << totalBytes << "    " << std::setw(20)
+              << totalOutOfSequence << std::setw(12) << totalDrops
               << std::endl;
     std::cout << std::endl;
 }
@@ -243,46 +622,75 @@ void RioConsumer::PrintReportRow(const TotalStats_t& stats,
  * @return TotalStats_t
  */
 TotalStats_t RioConsumer::GetMcTotals() {
-    TotalStats_t partialStats;
-    for (auto const& [key, value] : m_GroupStats) {
-        partialStats.TotalPackets += value.Packets.load();
-        partialStats.TotalBytes += value.Bytes.load();
-        partialStats.TotalOutOfOrder += value.OutOfOrder.load();
-        partialStats.TotalDrops += value.RxDropped.load();
-    }
-    return partialStats;
+    std::lock_guard<std::mutex> lock(m_GroupStatsLock);
+    return SumStats(m_GroupStats);
 }
 
-void RioConsumer::ReportWorker() {
-    uint64_t prevReportTime = 0;
-    int reportCount = 0;
+/**
+ * @brief Take one sample per report period: the deltas of the group stats and dequeue
+ *  counters, and the latency recorded since the previous sample. Everything is read from
+ *  counters the hot thread updates anyway, so the period can go down to MIN_REPORT_MS without
+ *  costing the hot thread anything; printing is left to the printer thread.
+ */
+void RioConsumer::SampleWorker() {
+    PinThread(1, "Sampler thread");
+    auto due = std::chrono::steady_clock::now() + std::chrono::nanoseconds(m_ReportPeriodNs);
+    uint64_t prevTime = utilities::get_unix_time();
     TotalStats_t prevStats;
+    RecvTelemetrySnapshot_t prevTelemetry;
 
-    while (ShouldStop()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        auto now = utilities::get_unix_time();
-        auto timeDelta = (double)(now - prevReportTime) / (double)utilities::ONE_SECOND;
-        if (timeDelta > REPORT_PERIOD_SEC) {
-            prevReportTime = now;
-            reportCount++;
-
-            if ((reportCount % 16) == 1) {
-                PrintReportHeader();
-            }
+    while (WaitForSample(due)) {
+        IntervalSample_t sample;
+        sample.TimeNs = utilities::get_unix_time();
+        sample.IntervalNs = sample.TimeNs - prevTime;
+        prevTime = sample.TimeNs;
+        const double seconds = static_cast<double>(sample.IntervalNs) / utilities::ONE_SECOND;
+
+        auto statsNow = GetMcTotals();
+        sample.TotalPackets = statsNow.TotalPackets;
+        sample.TotalOutOfOrder = statsNow.TotalOutOfOrder;
+        sample.TotalDrops = statsNow.TotalDrops;
+        sample.OutOfOrder = statsNow.TotalOutOfOrder - prevStats.TotalOutOfOrder;
+        sample.Drops = statsNow.TotalDrops - std::min(prevStats.TotalDrops, statsNow.TotalDrops);
+        sample.Pps = (statsNow.TotalPackets - prevStats.TotalPackets) / seconds;
+        sample.Bps = (statsNow.TotalBytes - prevStats.TotalBytes) * 8 / seconds;
+        prevStats = statsNow;
 
-            auto statsNow = GetMcTotals();
-
-            auto rxDeltaPackets = statsNow.TotalPackets - prevStats.TotalPackets;
-            auto rxDeltaBytes = statsNow.TotalBytes - prevStats.TotalBytes;
-            auto rxDeltaDropped
-                = statsNow.TotalDrops - std::min(prevStats.TotalDrops, statsNow.TotalDrops);
-            auto rxDeltaOoo = statsNow.TotalOutOfOrder - prevStats.TotalOutOfOrder;
-            auto rxPps = (double)rxDeltaPackets / timeDelta;
-            auto rxBps = (double)rxDeltaBytes * 8 / timeDelta;
-            PrintReportRow(statsNow, rxDeltaOoo, rxDeltaDropped, rxPps, rxBps);
-            prevStats = statsNow;
+        auto telemetryNow = m_Telemetry.Snapshot();
+        auto period = telemetryNow - prevTelemetry;
+        const uint64_t dequeues = period.Dequeues();
+        const double percent = dequeues ? 100.0 / dequeues : 0.0;
+        sample.BatchMean = dequeues ? static_cast<double>(period.Completions) / dequeues : 0.0;
+        sample.EmptyBatchPct = period.Batches.front() * percent;
+        sample.FullBatchPct = period.Batches.back() * percent;
+        sample.MinOutstanding = m_Telemetry.TakePeriodMinOutstanding();
+        sample.Overruns = period.Overruns;
+        prevTelemetry = telemetryNow;
+
+        if (m_Args->MeasureLatency) {
+            auto latency = m_IntervalLatency.Take();
+            m_Latency.Merge(latency);
+            sample.LatencyP50Ns = latency.Percentile(50);
+            sample.LatencyP99Ns = latency.Percentile(99);
+            sample.LatencyMaxNs = latency.Max();
+        }
+        m_Samples.TryPush(sample);
+        if (m_Publisher) {
+            const RingHealth_t health{
+                telemetryNow.Overruns,
+                static_cast<uint32_t>(sample.MinOutstanding * 100 / m_MaxOutstandingReceive)};
+            m_Publisher->Publish(m_GroupStats, m_GroupStatsLock, health);
         }
     }
 }
 
+void RioConsumer::PrintSample(const IntervalSample_t& sample, uint64_t index) {
+    if ((index % 16) == 0) {
+        PrintReportHeader();
+    }
+    PrintReportRow(TotalStats_t{sample.TotalPackets, 0, sample.TotalOutOfOrder, sample.TotalDrops},
+                   sample.OutOfOrder, sample.Drops, sample.Pps, sample.Bps);
+    PrintBatchRow(sample);
+}
+
 }  // namespace riosession
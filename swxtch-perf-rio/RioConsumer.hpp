@@ -1,24 +1,67 @@
 #include "RioSession.hpp"
+#include "Histogram.hpp"
+#include "RecvProcessor.hpp"
+#include "RioPolicies.hpp"
+#include "RecvTelemetry.hpp"
+#include "GroupChurn.hpp"
+#include "StatsAggregator.hpp"
 
 namespace riosession {
 
 class RioConsumer : public RioSession {
    private:
-    int JoinGroup(UINT32 grpaddr, UINT32 iaddr);
-    void JoinGroups(Ipv4Vect mcastAddrs);
-    void PostFirstRecvs(DWORD totalMessages);
-    void GroupStatsUpdate(const SOCKADDR_INET* addr,
-                          const size_t pktSize,
-                          const ProtocolHeader_t* pHdr) override;
+    int JoinGroup(SOCKET socket, UINT32 grpaddr, UINT32 iaddr);
+    int LeaveGroup(SOCKET socket, UINT32 grpaddr, UINT32 iaddr);
+    int ChangeMembership(size_t group, size_t port, bool join);
+    std::string Control(const std::vector<std::string>& words) override;
+    std::string ControlHelp() const override;
+    std::string JoinLive(const Ipv4Vect& groups);
+    std::string LeaveLive(const Ipv4Vect& groups);
+    void MarkMembership(uint32_t group, size_t port, bool joined);
+    std::string ListGroups() const;
+    bool IsChurned(const swxtch::net::Ipv4Addr_t& group) const;
+    void JoinGroups(SOCKET socket, const Ipv4Vect& mcastAddrs);
+    void OpenGroupSockets();
+    void PostFirstRecvs();
+    template <typename Recycle>
+    void Run(Recycle& recycle);
+    template <typename Completion, typename Recycle>
+    void RunLoop(Completion completion, Recycle& recycle);
     void GroupStatsPrint() override;
-    void InitMcAddrDescriptors() override;
     void PrintReportHeader();
     void PrintReportRow(const TotalStats_t& stats, const uint64_t& oooNow, const uint64_t& missNow, const double& pps, const double& bps);
-    void ReportWorker();
-    TotalStats_t GetMcTotals();
+    void SampleWorker();
+    void PrintSample(const IntervalSample_t& sample, uint64_t index) override;
+    ULONG ComputeRecvRingSize() const;
+    void PrintRingUsage() const;
+    void PrintBatchRow(const IntervalSample_t& sample) const;
+    void PrintChurn(const ChurnReport_t& churn) const;
+
+   private:
+    RecvSlotLayout_t m_Slot;
+    std::vector<SOCKET> m_Sockets;  // Per port, one per slice of groups. [0] is m_SocketHandle
+    ULONG m_SocketRecvs = 0;        // Receives posted on each socket
+    std::vector<size_t> m_SliceGroups;          // Groups of each slice, churned ones included
+    std::map<uint32_t, size_t> m_GroupSlices;   // Slice of each joined group, but churned ones
+    RecvTelemetry m_Telemetry;
+    LatencyHistogram m_Latency;          // Whole run, merged by the sampler
+    IntervalHistogram m_IntervalLatency;  // Written by the hot thread
+    RioRecvTransport m_Transport;
+    RecvProcessor<> m_Processor;
+    std::unique_ptr<EchoRecycle> m_Echo;  // The reflector's sends
+    std::unique_ptr<GroupChurn> m_Churn;  // With --churn_rate only
+    std::unique_ptr<StatsPublisher> m_Publisher;  // With --aggregator only
 
    public:
     void Start() override;
+    void CleanUpRIO() override;
+    TotalStats_t GetMcTotals();
+    const LatencyHistogram& Latency() const {
+        return m_Latency;
+    }
+    const ChurnReport_t* Churn() const {
+        return m_Churn ? &m_Churn->Report() : nullptr;
+    }
     RioConsumer(args_t* args, volatile sig_atomic_t* signal);
     ~RioConsumer() = default;
 };
@@ -0,0 +1,250 @@
+#pragma once
+// clang-format off
+#include "stdafx.h"
+#include <vector>
+#include "Utilities.hpp"
+#include "RecvProcessor.hpp"
+#include "RecvSlot.hpp"
+// clang-format on
+
+/**
+ * Compile-time policies of the consumer receive loop (see RioConsumer::RunLoop). A transport
+ * provides PostRecv(slot), Repost(context) of a completed request and Dequeue(results, max); a
+ * completion strategy provides Notify()
+ * and Wait(), called before each dequeue, and Processed(), called after a non empty batch; a
+ * recycle policy is called with every completion once it is accounted, and provides Reap(),
+ * called before each wait. MockTransport is the in-memory transport.
+ */
+namespace riosession {
+
+/**
+ * @brief Transport over RIO request queues, one per bound port, sharing a completion queue.
+ *  The RIO calls stay indirect, they are only reachable through the extension function table,
+ *  but the two pointers are copied next to the handles they use so the loop does not chase the
+ *  session for them.
+ */
+class RioRecvTransport {
+   public:
+    RioRecvTransport() = default;
+    RioRecvTransport(const RIO_EXTENSION_FUNCTION_TABLE& rioFuncTable,
+                     std::vector<RIO_RQ> requestQueues,
+                     RIO_CQ completionQueue,
+                     RIO_BUFFERID bufferId,
+                     const RecvSlotLayout_t& slot,
+                     RIO_BUFFERID remoteBufferId = RIO_INVALID_BUFFERID)
+        : m_ReceiveEx(rioFuncTable.RIOReceiveEx),
+          m_DequeueCompletion(rioFuncTable.RIODequeueCompletion),
+          m_RequestQueues(std::move(requestQueues)),
+          m_CompletionQueue(completionQueue),
+          m_BufferId(bufferId),
+          m_Slot(slot),
+          m_RemoteBufferId(remoteBufferId) {
+    }
+
+    /**
+     * @brief Post a receive into a slot on the request queue of a port. The descriptors are
+     *  built on the stack, RIO copies them into the request queue. The request context is the
+     *  slot index, with the queue in the high 32 bits, so a completion leads straight to its own
+     *  payload and address whatever the completion order, and goes back to its own queue.
+     *  With a remote address buffer, the sender's address goes to the slot's entry in it.
+     */
+    inline void PostRecv(ULONG slot, ULONG queue = 0) {
+        const ULONG offset = slot * m_Slot.Stride;
+        RIO_BUF data{m_BufferId, offset, m_Slot.DataSize};
+        RIO_BUF localAddr{m_BufferId, offset + m_Slot.AddrOffset, ADDR_SIZE};
+        RIO_BUF remoteAddr{m_RemoteBufferId, slot * ADDR_SIZE, ADDR_SIZE};
+        DWORD recvFlags = 0;
+        const ULONGLONG context = slot | (static_cast<ULONGLONG>(queue) << 32);
+        if (!m_ReceiveEx(m_RequestQueues[queue], &data, 1, &localAddr,
+                         m_RemoteBufferId != RIO_INVALID_BUFFERID ? &remoteAddr : NULL, NULL,
+                         NULL, recvFlags,
+                         reinterpret_cast<PVOID>(static_cast<ULONG_PTR>(context)))) {
+            utilities::ErrorExit("RIOReceive");
+        }
+    }
+
+    inline void Repost(ULONGLONG context) {
+        PostRecv(static_cast<ULONG>(context), static_cast<ULONG>(context >> 32));
+    }
+
+    inline ULONG Dequeue(RIORESULT* results, ULONG maxResults) {
+        return m_DequeueCompletion(m_CompletionQueue, results, maxResults);
+    }
+
+   private:
+    decltype(RIO_EXTENSION_FUNCTION_TABLE::RIOReceiveEx) m_ReceiveEx = nullptr;
+    decltype(RIO_EXTENSION_FUNCTION_TABLE::RIODequeueCompletion) m_DequeueCompletion = nullptr;
+    std::vector<RIO_RQ> m_RequestQueues;
+    RIO_CQ m_CompletionQueue = RIO_INVALID_CQ;
+    RIO_BUFFERID m_BufferId = RIO_INVALID_BUFFERID;
+    RecvSlotLayout_t m_Slot;
+    RIO_BUFFERID m_RemoteBufferId = RIO_INVALID_BUFFERID;  // Senders' addresses, when wanted
+};
+
+/**
+ * @brief Recycle policy of the consumer: a completed receive is reposted right away.
+ */
+class RepostRecycle {
+   public:
+    explicit RepostRecycle(RioRecvTransport* transport) : m_Transport(transport) {
+    }
+
+    inline void operator()(const RIORESULT& result) {
+        m_Transport->Repost(result.RequestContext);
+    }
+
+    inline void Reap() {
+    }
+
+    ULONG Held() const {
+        return 0;
+    }
+
+   private:
+    RioRecvTransport* m_Transport;
+};
+
+/**
+ * @brief Recycle policy of the reflector: a received datagram is sent back to its sender from
+ *  its own receive slot, with no copy, on the request queue it came from and to the address
+ *  RIO wrote in the remote address buffer (see RioRecvTransport). The slot is reposted once
+ *  that send completed. The sends complete on their own CQ, only ever polled by Reap, so the
+ *  receive loop must poll too: with every slot waiting on its send, no receive would complete
+ *  to wake it up. Every slot is either received or sent into, so a request queue with as many
+ *  sends as receives never refuses one.
+ */
+class EchoRecycle {
+   public:
+    EchoRecycle(const RIO_EXTENSION_FUNCTION_TABLE& rioFuncTable,
+                RioRecvTransport* transport,
+                std::vector<RIO_RQ> requestQueues,
+                RIO_CQ sendQueue,
+                RIO_BUFFERID bufferId,
+                RIO_BUFFERID remoteBufferId,
+                const RecvSlotLayout_t& slot)
+        : m_SendEx(rioFuncTable.RIOSendEx),
+          m_DequeueCompletion(rioFuncTable.RIODequeueCompletion),
+          m_Transport(transport),
+          m_RequestQueues(std::move(requestQueues)),
+          m_SendQueue(sendQueue),
+          m_BufferId(bufferId),
+          m_RemoteBufferId(remoteBufferId),
+          m_Slot(slot),
+          m_Results(MAX_RIO_RESULTS) {
+    }
+
+    inline void operator()(const RIORESULT& result) {
+        const auto slot = static_cast<ULONG>(result.RequestContext);
+        RIO_BUF data{m_BufferId, slot * m_Slot.Stride, result.BytesTransferred};
+        RIO_BUF remoteAddr{m_RemoteBufferId, slot * ADDR_SIZE, ADDR_SIZE};
+        if (!m_SendEx(m_RequestQueues[static_cast<ULONG>(result.RequestContext >> 32)], &data, 1,
+                      NULL, &remoteAddr, NULL, NULL, 0,
+                      reinterpret_cast<PVOID>(static_cast<ULONG_PTR>(result.RequestContext)))) {
+            utilities::ErrorExit("RIOSendEx");
+        }
+        m_Echoes++;
+    }
+
+    /**
+     * @brief Repost the slots of the completed sends.
+     */
+    inline void Reap() {
+        const ULONG numResults
+            = m_DequeueCompletion(m_SendQueue, m_Results.data(), MAX_RIO_RESULTS);
+        if (RIO_CORRUPT_CQ == numResults) {
+            utilities::ErrorExit("RIODequeueCompletion");
+        }
+        for (ULONG i = 0; i < numResults; i++) {
+            m_Transport->Repost(m_Results[i].RequestContext);
+        }
+        m_Reaped += numResults;
+    }
+
+    /**
+     * @brief Slots out of the receive ring, their echo not sent yet.
+     */
+    ULONG Held() const {
+        return static_cast<ULONG>(m_Echoes - m_Reaped);
+    }
+
+    uint64_t Echoes() const {
+        return m_Echoes;
+    }
+
+   private:
+    decltype(RIO_EXTENSION_FUNCTION_TABLE::RIOSendEx) m_SendEx;
+    decltype(RIO_EXTENSION_FUNCTION_TABLE::RIODequeueCompletion) m_DequeueCompletion;
+    RioRecvTransport* m_Transport;
+    std::vector<RIO_RQ> m_RequestQueues;
+    RIO_CQ m_SendQueue;
+    RIO_BUFFERID m_BufferId;
+    RIO_BUFFERID m_RemoteBufferId;
+    RecvSlotLayout_t m_Slot;
+    std::vector<RIORESULT> m_Results;
+    uint64_t m_Echoes = 0;  // Hot thread only, read once it stopped
+    uint64_t m_Reaped = 0;
+};
+
+/**
+ * @brief Sleep on the IOCP until RIO signals completions: RIONotify arms the CQ once a batch
+ *  was processed, and the wait gives up after 100ms so the stop conditions are checked.
+ */
+class NotifyCompletion {
+   public:
+    NotifyCompletion(const RIO_EXTENSION_FUNCTION_TABLE& rioFuncTable,
+                     RIO_CQ completionQueue,
+                     HANDLE hIOCP)
+        : m_Notify(rioFuncTable.RIONotify), m_CompletionQueue(completionQueue), m_hIOCP(hIOCP) {
+    }
+
+    /**
+     * @return bool true if the CQ was armed
+     */
+    inline bool Notify() {
+        if (!m_ShouldNotify) {
+            return false;
+        }
+        INT notifyResult = m_Notify(m_CompletionQueue);
+        if (notifyResult != ERROR_SUCCESS) {
+            utilities::ErrorExit("RIONotify", notifyResult);
+        }
+        return true;
+    }
+
+    inline void Wait() {
+        DWORD numberOfBytes = 0;
+        ULONG_PTR completionKey = 0;
+        OVERLAPPED* pOverlapped = 0;
+        if (!::GetQueuedCompletionStatus(m_hIOCP, &numberOfBytes, &completionKey, &pOverlapped,
+                                         100)) {
+            m_ShouldNotify = false;
+        }
+    }
+
+    inline void Processed() {
+        m_ShouldNotify = true;
+    }
+
+   private:
+    decltype(RIO_EXTENSION_FUNCTION_TABLE::RIONotify) m_Notify;
+    RIO_CQ m_CompletionQueue;
+    HANDLE m_hIOCP;
+    bool m_ShouldNotify = true;
+};
+
+/**
+ * @brief Never wait: dequeue in a loop. Spends the whole core, saves the notification and the
+ *  wake up latency.
+ */
+class PollCompletion {
+   public:
+    inline bool Notify() {
+        return false;
+    }
+    inline void Wait() {
+    }
+    inline void Processed() {
+    }
+};
+
+}  // namespace riosession
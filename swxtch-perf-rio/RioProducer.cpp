@@ -1,23 +1,64 @@
 #include "RioProducer.hpp"
 
 namespace riosession {
-RioProducer::RioProducer(args_t* args, volatile sig_atomic_t* signal) : RioSession(args, signal) {
+RioProducer::RioProducer(args_t* args, volatile sig_atomic_t* signal)
+    : RioSession(args, signal, args->AdaptRate ? ADAPT_PERIOD_SEC : PRODUCER_REPORT_PERIOD_SEC) {
     BindSocket(0, args->IfIndex);  // Bind to any port on ifIndex addr
-    m_MaxOutstandingReceive = 0;
+    m_MaxOutstandingReceive = m_Args->Rtt ? ECHO_RECVS : 0;
     m_MaxReceiveDataBuffers = 1;
-    m_NumberOfMcGroups = m_Args->McastAddrStr.size();
-    m_MaxOutstandingSend = m_Args->PacketRate * m_NumberOfMcGroups;
+    m_NumberOfStreams = static_cast<UINT>(m_Args->Streams());
+    if (!m_Args->PcapFile.empty()) {
+        m_Pcap = std::make_unique<PcapReader>(m_Args->PcapFile);
+    } else if (!m_Args->LineRate
+               && (m_Args->Profile != PROFILE_CONSTANT || !m_Args->RateFile.empty())) {
+        m_Profile = std::make_unique<TrafficProfile>(m_Args);
+        double totalRate = 0;
+        for (auto rate : m_Profile->Rates()) {
+            totalRate += rate;
+        }
+        std::cout << "Traffic profile: " << m_Profile->Name() << ", "
+                  << m_Profile->NumberOfDepartures() << " departures precomputed, "
+                  << totalRate << " pps over all streams, cycle of "
+                  << m_Profile->PeriodNs() / 1000000 << "ms" << std::endl;
+    }
+    // The send ring is fixed, whatever the rate: at least one slot per stream so that a whole
+    // round of streams can be in flight
+    m_MaxOutstandingSend = std::max<ULONG>(MAX_PENDING_SENDS, m_NumberOfStreams);
     m_MaxSendDataBuffers = 1;
     m_SpinDuration = (int64_t)(1e9 / (double)args->PacketRate);
-    m_RioBuffDescr = std::make_unique<RIO_BUF[]>(m_MaxOutstandingSend);
-    std::cout << "Max Outstanding sends: " << m_MaxOutstandingSend << std::endl;
-    SendOnInterface(args->IfIndex);
+    m_StreamRate = args->PacketRate;
+    if (m_Args->AdaptRate) {
+        // The search bounds are sums over the streams, the adapted rate is per stream
+        m_Adapter = std::make_unique<RateAdapter>(
+            args->AdaptLossPct,
+            std::max<int64_t>(args->SearchMinPacketRate / m_NumberOfStreams, 1),
+            std::max<int64_t>(args->SearchMaxPacketRate / m_NumberOfStreams, 1));
+        m_Feedback = std::make_unique<StatsListener>(args->Aggregator, args->AggregatorPort, 0);
+        ApplyRate(m_Adapter->Rate());
+    }
+    if (!m_Args->Unicast) {
+        SendOnInterface(args->IfIndex);  // Unicast goes out of the bound address's route
+    }
     InitializeRIO();
     CreateCompletionQueue(static_cast<DWORD>(m_MaxOutstandingSend));
-    CreateRequestQueue();
-    m_RioBuffPtr = AllocateAndRegisterBuffer(EXPECTED_DATA_SIZE,
-                                             static_cast<DWORD>(m_Args->PacketRate), m_RioBuffId);
-    m_McAddrBuffPtr = AllocateAndRegisterBuffer(ADDR_SIZE, m_NumberOfMcGroups, m_McAddrBuffId);
+    if (m_Args->Rtt) {
+        m_EchoQueue = CreatePolledCompletionQueue(ECHO_RECVS);
+        m_RequestQueue = CreateRequestQueue(m_SocketHandle, m_MaxOutstandingReceive, m_EchoQueue,
+                                            m_CompletionQueue);
+    } else {
+        CreateRequestQueue();
+    }
+    if (m_Pcap) {
+        InitReplay();
+    } else {
+        InitSendRing(static_cast<DWORD>(m_Args->PayloadSize));
+    }
+    if (m_Args->Rtt) {
+        InitEchoRing();
+    }
+    m_AddrSlots = m_NumberOfStreams + (m_Args->Control != CONTROL_OFF ? LIVE_STREAM_SLOTS : 0);
+    m_McAddrBuffPtr
+        = AllocateAndRegisterBuffer(ADDR_SIZE, m_AddrSlots, m_McAddrBuffId, m_McAddrBuffSize);
     InitMcAddrDescriptors();
 }
 
@@ -30,162 +71,522 @@ void RioProducer::SendOnInterface(const std::string& iaddr) {
     }
 }
 
+/**
+ * @brief Describe every registered address slot and fill those of the streams of the
+ *  arguments, which are also the first ones sent to.
+ */
 void RioProducer::InitMcAddrDescriptors() {
     DWORD offset = 0;
-    DWORD recvFlags = 0;
-    DWORD data_offset = 0;
-    ULONGLONG packetCounter = 0;
-    m_McAddrDescr = std::make_unique<RIO_BUF[]>(m_NumberOfMcGroups);
-    for (DWORD i = 0; i < m_NumberOfMcGroups; i++) {
+    m_McAddrDescr = std::make_unique<RIO_BUF[]>(m_AddrSlots);
+    for (DWORD i = 0; i < m_AddrSlots; i++) {
         m_McAddrDescr[i].BufferId = m_McAddrBuffId;
         m_McAddrDescr[i].Offset = offset;
         m_McAddrDescr[i].Length = ADDR_SIZE;
-
-        auto sockAddr = reinterpret_cast<SOCKADDR_INET*>(m_McAddrBuffPtr + offset);
-        sockAddr->Ipv4.sin_family = AF_INET;
-        sockAddr->Ipv4.sin_port = htons(m_Args->McastPort);
-        uint32_t mcAddr = 0;
-        auto mcastStrAddr = m_Args->McastAddrStr[i].str();
-        auto res = inet_pton(AF_INET, mcastStrAddr.c_str(), &mcAddr);
-        if (res != 1) {
-            utilities::ErrorExit("Converting Mcast Address");
-        }
-        sockAddr->Ipv4.sin_addr.s_addr = mcAddr;
         offset += ADDR_SIZE;
     }
+    // Streams are group major: stream i is group i / ports on port i % ports
+    const size_t ports = m_Args->McastPorts.size();
+    for (DWORD i = 0; i < m_NumberOfStreams; i++) {
+        auto key = MakeStreamKey(m_Args->McastAddrStr[i / ports].ipNetOrder(),
+                                 htons(m_Args->McastPorts[i % ports]));
+        SetStreamAddr(i, key);
+        m_AddrSlotOf[key] = i;
+        m_Streams.push_back(SendStream_t{key, i, &m_GroupStats.at(key)});
+    }
+    m_LiveStreams.Publish(m_Streams);
+    m_ActiveStreams = m_Streams.size();
 }
 
-uint64_t RioProducer::PostFirstSend(DWORD totalMessages) {
-    DWORD offset = 0;
-    DWORD sendFlags = 0;
-    uint64_t sequenceNumber = 0;
-    DWORD groupCounter = 0;
-    // Fill @totalMessages descriptors and initialize @totalMessages
-    // packets with data.
-    // There are PacketRate * NumberOfMcGroups descriptors but only PacketRate Real Packets
-    for (DWORD i = 0; i < m_Args->PacketRate; ++i) {
-        for (DWORD j = 0; j < m_NumberOfMcGroups; j++) {
-            m_RioBuffDescr[(m_NumberOfMcGroups * i) + j].BufferId = m_RioBuffId;
-            m_RioBuffDescr[(m_NumberOfMcGroups * i) + j].Offset = offset;
-            m_RioBuffDescr[(m_NumberOfMcGroups * i) + j].Length = EXPECTED_DATA_SIZE;
-        }
-        auto pHeader = reinterpret_cast<ProtocolHeader_t*>(m_RioBuffPtr + offset);
-        pHeader->Token = 490u;
-        pHeader->CmdType = 0;
-        pHeader->Seq = i;
-        pHeader->Timestamp = utilities::get_unix_time();
-        offset += EXPECTED_DATA_SIZE;
+void RioProducer::SetStreamAddr(DWORD addrSlot, StreamKey_t key) {
+    auto sockAddr
+        = reinterpret_cast<SOCKADDR_INET*>(m_McAddrBuffPtr + m_McAddrDescr[addrSlot].Offset);
+    sockAddr->Ipv4.sin_family = AF_INET;
+    sockAddr->Ipv4.sin_port = StreamPort(key);
+    sockAddr->Ipv4.sin_addr.s_addr = StreamGroup(key);
+}
+
+/**
+ * @brief Send PacketRate packets per second to every stream (group and port), or as many as the
+ * NIC takes with --line_rate. Each round takes a slot per stream from the send ring and stamps
+ * a fresh Seq/Timestamp in it, so a packet is never modified while the NIC may still be reading
+ * it.
+ */
+void RioProducer::Start() {
+    if (m_Pcap) {
+        ReplayCapture();
+        return;
+    }
+    if (m_Profile) {
+        SendProfile();
+        return;
+    }
+    ULONGLONG sequenceNumber = 0;
+    m_Timing.setStart();
+    StartPrinter();
+    m_ReportThread = std::make_unique<std::thread>(&RioProducer::SpinWorker, this);
+    StartEchoes();
+    StartControl();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    while (ShouldStop()) {
+        if (m_Paused.load(std::memory_order_relaxed)) {
+            ReapSendCompletions(false);
+            std::this_thread::sleep_for(PAUSE_POLL_PERIOD);
+            continue;
+        }
+        auto now = utilities::get_unix_time();
+        uint64_t tsc = StageProfile::Now();
+        // The streams added or removed live are picked up here, once per round
+        for (const auto& stream : m_LiveStreams.Acquire()) {
+            DWORD slot = AcquireSendSlot();
+            auto pHeader
+                = reinterpret_cast<ProtocolHeader_t*>(m_RioBuffPtr + slot * m_SendSlotSize);
+            FillHeader(pHeader, sequenceNumber, now);
+            if (m_Args->Rtt) {
+                StampStream(pHeader, stream.Key);
+            }
+            m_Stages.Mark(Stage::Process, tsc);
+            PostSend(slot, m_Args->PayloadSize, stream);
+            m_Stages.Mark(Stage::Post, tsc);
+        }
+        m_LiveStreams.Release();
         sequenceNumber++;
+        // Credits come back while spinning is due anyway
+        ReapSendCompletions(false);
+        m_Stages.Mark(Stage::Dequeue, tsc);
+        if (!m_Args->LineRate) {
+            utilities::spin(m_SpinDuration.load());
+            m_Stages.Mark(Stage::Spin, tsc);
+        }
+        m_Stages.EndOfBatch("Producer");
     }
+    StopControl();
+    JoinThread(m_ReportThread);
+    StopEchoes();
+    StopPrinter();
+    PrintResults();
+}
 
+/**
+ * @brief Allocate and register the send ring: m_MaxOutstandingSend slots of @p slotSize
+ * bytes, rounded up to whole cache lines. A slot is owned by its send from RIOSendEx until
+ * the completion is reaped; all the slots start free.
+ *
+ * @param slotSize Largest datagram sent
+ */
+void RioProducer::InitSendRing(DWORD slotSize) {
+    m_SendSlotSize = static_cast<DWORD>(utilities::RoundUp(slotSize, CACHE_LINE_SIZE));
+    m_RioBuffPtr = AllocateAndRegisterBuffer(m_SendSlotSize, m_MaxOutstandingSend, m_RioBuffId,
+                                             m_RioBuffSize);
+    m_FreeSlots.reserve(m_MaxOutstandingSend);
     for (DWORD i = 0; i < m_MaxOutstandingSend; i++) {
-        // Send the same packet for each Multicast Group
-        if (!m_RioFuncTable.RIOSendEx(m_RequestQueue, &m_RioBuffDescr[i], 1, NULL,
-                                      &m_McAddrDescr[i % m_Args->McastAddrStr.size()], NULL, NULL,
-                                      sendFlags, &m_RioBuffDescr[i])) {
+        m_FreeSlots.push_back(m_MaxOutstandingSend - 1 - i);
+    }
+    m_SendResults = std::make_unique<RIORESULT[]>(MAX_RIO_RESULTS);
+    std::cout << "Send ring: " << m_MaxOutstandingSend << " slots of " << m_SendSlotSize
+              << " bytes (" << m_RioBuffSize / 1024 << " KB registered)" << std::endl;
+}
+
+/**
+ * @brief Take a slot of the send ring, waiting for send completions to return one if the
+ * whole ring is in flight. Such a wait is a stall: the sender is ahead of the NIC.
+ */
+inline DWORD RioProducer::AcquireSendSlot() {
+    if (m_FreeSlots.empty()) {
+        m_SendStalls++;
+        do {
+            ReapSendCompletions(true);
+        } while (m_FreeSlots.empty());
+    }
+    DWORD slot = m_FreeSlots.back();
+    m_FreeSlots.pop_back();
+    return slot;
+}
+
+/**
+ * @brief Send the first @p length bytes of a slot to a stream. The slot index is the request
+ * context, handed back to the free list by ReapSendCompletions.
+ * A full send queue (WSAENOBUFS) is backpressure, not an error: it is counted as a stall and
+ * the send is retried once completions have been reaped.
+ */
+inline void RioProducer::PostSend(DWORD slot, DWORD length, const SendStream_t& stream) {
+    RIO_BUF data{m_RioBuffId, slot * m_SendSlotSize, length};
+    DWORD sendFlags = 0;
+    auto nextAddr = &m_McAddrDescr[stream.AddrSlot];
+    while (!m_RioFuncTable.RIOSendEx(m_RequestQueue, &data, 1, NULL, nextAddr, NULL, NULL,
+                                     sendFlags, reinterpret_cast<PVOID>(ULONG_PTR{slot}))) {
+        if (::WSAGetLastError() != WSAENOBUFS) {
             utilities::ErrorExit("RIOSend");
         }
-        m_TotalPkts++;  // atomic fetch_add(1)
-        groupCounter = (groupCounter + 1) % m_NumberOfMcGroups;
-        auto mcAddr
-            = (SOCKADDR_INET*)(m_McAddrBuffPtr + m_McAddrDescr[i % m_NumberOfMcGroups].Offset);
-        GroupStatsUpdate(mcAddr, EXPECTED_DATA_SIZE, nullptr);
-        // Spin and generate a new packet sequence after sending  groupCounter Packets
-        if (!groupCounter) {
-            utilities::spin(m_SpinDuration.load());
-        }
+        m_SendStalls++;
+        ReapSendCompletions(true);
     }
-    return sequenceNumber;
+    UpdateTxStats(*stream.Stats, length);
+    m_TotalPkts++;  // atomic fetch add
 }
 
-void RioProducer::Start() {
+/**
+ * @brief Size the send ring for the biggest datagram of the capture.
+ */
+void RioProducer::InitReplay() {
+    InitSendRing(static_cast<DWORD>(
+        std::max<size_t>(m_Pcap->MaxPayloadSize(), sizeof(ProtocolHeader_t))));
+    std::cout << "Replaying " << m_Pcap->Packets().size() << " datagrams from "
+              << m_Args->PcapFile << std::endl;
+    std::cout << "\tCapture duration: " << m_Pcap->DurationNs() / 1000000 << "ms" << std::endl;
+    std::cout << "\t" << m_Pcap->NumberOfFlows() << " captured destinations mapped over "
+              << m_NumberOfStreams << " streams (group and port)" << std::endl;
+    if (m_Args->ReplaySpeed > 0) {
+        std::cout << "\tSpeed factor: " << m_Args->ReplaySpeed << std::endl;
+    } else {
+        std::cout << "\tSpeed factor: as fast as possible" << std::endl;
+    }
+}
+
+/**
+ * @brief Give back to the free list the slots of every completed send: the send credits.
+ *
+ * @param wait Block until at least one send completes
+ */
+void RioProducer::ReapSendCompletions(bool wait) {
     DWORD numberOfBytes = 0;
     ULONG_PTR completionKey = 0;
     OVERLAPPED* pOverlapped = 0;
-    DWORD sendFlags = 0;
-    ULONGLONG sequenceNumber = 0;
-    DWORD maxResults = m_MaxOutstandingSend;
-    DWORD groupCounter = 0;
-    m_Timing.setStart();
-    auto results = std::make_unique<RIORESULT[]>(maxResults);
-    std::cout << "Max Results: " << maxResults << std::endl;
-    m_ReportThread = std::make_unique<std::thread>(&RioProducer::SpinWorker, this);
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-    sequenceNumber = PostFirstSend(m_MaxOutstandingSend);
 
-    while (ShouldStop()) {
+    if (wait) {
         NotifyCompletionQueue();
         if (!::GetQueuedCompletionStatus(m_hIOCP, &numberOfBytes, &completionKey, &pOverlapped,
                                          INFINITE)) {
             utilities::ErrorExit("GetQueuedCompletionStatus");
         }
+    }
+    ULONG numResults = m_RioFuncTable.RIODequeueCompletion(m_CompletionQueue, m_SendResults.get(),
+                                                           MAX_RIO_RESULTS);
+    if (RIO_CORRUPT_CQ == numResults) {
+        utilities::ErrorExit("RIODequeueCompletion");
+    }
+    for (DWORD i = 0; i < numResults; ++i) {
+        m_FreeSlots.push_back(static_cast<DWORD>(m_SendResults[i].RequestContext));
+    }
+}
 
-        ULONG numResults
-            = m_RioFuncTable.RIODequeueCompletion(m_CompletionQueue, results.get(), maxResults);
+/**
+ * @brief Send every datagram of the capture, in order, to the stream (group and port) its
+ * captured destination is mapped to. Datagrams are due at their capture offset divided by the
+ * speed factor, or back to back with a speed of 0. The capture is looped until the run ends.
+ * The payload is copied into a free registered slot and the slot is owned by the send until
+ * its completion is reaped, so Seq/Timestamp rewriting never touches a buffer in flight.
+ */
+void RioProducer::ReplayCapture() {
+    const auto& packets = m_Pcap->Packets();
+    const double speed = m_Args->ReplaySpeed;
+    const uint64_t baseTs = packets.front().TimestampNs;
+    // A pass ends one average inter-packet gap after its last datagram
+    const uint64_t passDuration = m_Pcap->DurationNs() + m_Pcap->DurationNs() / packets.size();
+    std::vector<uint64_t> streamSequence(m_NumberOfStreams, 0);
+    uint64_t passOffset = 0;
+    size_t index = 0;
 
-        if (0 == numResults || RIO_CORRUPT_CQ == numResults) {
-            utilities::ErrorExit("RIODequeueCompletion");
+    m_Timing.setStart();
+    StartPrinter();
+    m_ReportThread = std::make_unique<std::thread>(&RioProducer::SpinWorker, this);
+    StartControl();
+    auto replayStart = std::chrono::steady_clock::now();
+
+    while (ShouldStop()) {
+        const auto& pkt = packets[index];
+        uint64_t tsc = StageProfile::Now();
+        if (speed > 0) {
+            uint64_t captureOffset
+                = passOffset + (pkt.TimestampNs > baseTs ? pkt.TimestampNs - baseTs : 0);
+            auto due = replayStart
+                       + std::chrono::nanoseconds(static_cast<int64_t>(captureOffset / speed));
+            while (std::chrono::steady_clock::now() < due && ShouldStop()) {
+                ReapSendCompletions(false);
+            }
+            if (std::chrono::steady_clock::now() < due) {
+                break;  // Stopped during a gap of the capture
+            }
         }
+        m_Stages.Mark(Stage::Spin, tsc);
+        DWORD slot = AcquireSendSlot();
+        char* data = m_RioBuffPtr + slot * m_SendSlotSize;
+        memcpy(data, pkt.Payload, pkt.Length);
 
-        for (DWORD i = 0; i < numResults; ++i) {
-            auto pBuffer = reinterpret_cast<RIO_BUF*>(results[i].RequestContext);
-            auto pHeader = reinterpret_cast<ProtocolHeader_t*>(m_RioBuffPtr + pBuffer->Offset);
-            pHeader->Seq = sequenceNumber;
+        DWORD stream = pkt.FlowId % m_NumberOfStreams;
+        if (m_Args->RewriteHeader && pkt.Length >= sizeof(ProtocolHeader_t)) {
+            auto pHeader = reinterpret_cast<ProtocolHeader_t*>(data);
+            pHeader->Seq = streamSequence[stream]++;
             pHeader->Timestamp = utilities::get_unix_time();
+        }
 
-            auto nextAddr = &m_McAddrDescr[i % m_NumberOfMcGroups];
+        m_Stages.Mark(Stage::Process, tsc);
+        PostSend(slot, pkt.Length, m_Streams[stream]);
+        m_Stages.Mark(Stage::Post, tsc);
+        m_Stages.EndOfBatch("Producer");
 
-            if (!m_RioFuncTable.RIOSendEx(m_RequestQueue, pBuffer, 1, NULL, nextAddr, NULL, NULL,
-                                          sendFlags, pBuffer)) {
-                utilities::ErrorExit("RIOSend");
-            }
-            auto mcAddr = reinterpret_cast<SOCKADDR_INET*>(m_McAddrBuffPtr + nextAddr->Offset);
-            GroupStatsUpdate(mcAddr, EXPECTED_DATA_SIZE, nullptr);
-            m_TotalPkts++;  // atomic fetch add
-            groupCounter = (groupCounter + 1) % m_NumberOfMcGroups;
-            if (!groupCounter) {
-                sequenceNumber++;
-                utilities::spin(m_SpinDuration.load());
-            }
+        if (++index == packets.size()) {
+            index = 0;
+            passOffset += passDuration;
         }
     }
+    StopControl();
+    JoinThread(m_ReportThread);
+    StopPrinter();
+    PrintResults();
+}
+
+/**
+ * @brief Send the synthetic packets at the departures of the precomputed traffic profile.
+ * Each stream has its own Seq so a consumer tracks drops per stream whatever its rate.
+ * Departures that are already late are sent right away, so a slow period is caught up.
+ */
+void RioProducer::SendProfile() {
+    std::vector<uint64_t> streamSequence(m_NumberOfStreams, 0);
+
+    m_Timing.setStart();
+    StartPrinter();
+    m_ReportThread = std::make_unique<std::thread>(&RioProducer::SpinWorker, this);
+    StartEchoes();
+    StartControl();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto profileStart = std::chrono::steady_clock::now();
+
+    while (ShouldStop()) {
+        uint32_t stream;
+        auto due = profileStart + std::chrono::nanoseconds(m_Profile->Next(stream));
+        uint64_t tsc = StageProfile::Now();
+        while (std::chrono::steady_clock::now() < due && ShouldStop()) {
+            ReapSendCompletions(false);
+        }
+        if (std::chrono::steady_clock::now() < due) {
+            break;  // Stopped during a gap between departures
+        }
+        m_Stages.Mark(Stage::Spin, tsc);
+        DWORD slot = AcquireSendSlot();
+        auto pHeader = reinterpret_cast<ProtocolHeader_t*>(m_RioBuffPtr + slot * m_SendSlotSize);
+        FillHeader(pHeader, streamSequence[stream]++, utilities::get_unix_time());
+        if (m_Args->Rtt) {
+            StampStream(pHeader, m_Streams[stream].Key);
+        }
+        m_Stages.Mark(Stage::Process, tsc);
+        PostSend(slot, m_Args->PayloadSize, m_Streams[stream]);
+        m_Stages.Mark(Stage::Post, tsc);
+        m_Stages.EndOfBatch("Producer");
+    }
+    StopControl();
+    JoinThread(m_ReportThread);
+    StopEchoes();
+    StopPrinter();
+    PrintResults();
+}
+
+void RioProducer::PrintResults() {
     PrintTimings(m_TotalPkts, 0);
+    std::cout << "\tSend stalls (waits for send completions): " << m_SendStalls << std::endl;
+    if (m_Adapter) {
+        std::cout << "\tAdapted rate: ";
+        if (m_Adapter->Good() == 0) {
+            std::cout << "no rate found within " << m_Args->AdaptLossPct << "% loss";
+        } else {
+            std::cout << m_Adapter->Good() << " pps per stream within " << m_Args->AdaptLossPct
+                      << "% loss, " << (m_Adapter->Converged() ? "converged" : "still searching");
+        }
+        std::cout << std::endl;
+    }
+    if (m_Args->Rtt) {
+        PrintRtt();
+    }
+    m_Stages.PrintTotals("Producer");
     GroupStatsPrint();
-    JoinThread(m_ReportThread);
 }
 
+/**
+ * @brief Allocate, register and post the receives of the echoes: a reflector sends them back to
+ *  the sending socket. The slots are laid out as the consumer's (see RecvSlotLayout_t).
+ */
+void RioProducer::InitEchoRing() {
+    m_EchoSlot = RecvSlotLayout_t(static_cast<DWORD>(m_Args->PayloadSize));
+    m_EchoBuffPtr
+        = AllocateAndRegisterBuffer(m_EchoSlot.Stride, ECHO_RECVS, m_EchoBuffId, m_EchoBuffSize);
+    m_EchoTransport = RioRecvTransport(m_RioFuncTable, {m_RequestQueue}, m_EchoQueue,
+                                       m_EchoBuffId, m_EchoSlot);
+    for (ULONG slot = 0; slot < ECHO_RECVS; slot++) {
+        m_EchoTransport.PostRecv(slot);
+    }
+    std::cout << "Echo ring: " << ECHO_RECVS << " preposted receives of " << m_EchoSlot.Stride
+              << " bytes" << std::endl;
+}
+
+void RioProducer::StartEchoes() {
+    if (m_Args->Rtt) {
+        m_EchoThread = std::make_unique<std::thread>(&RioProducer::EchoWorker, this);
+    }
+}
+
+/**
+ * @brief Stop the echo thread once the echoes of the last sends had ECHO_DRAIN_PERIOD to come
+ *  back, and take the round trips it recorded since the last sample. After the sampler
+ *  stopped.
+ */
+void RioProducer::StopEchoes() {
+    if (!m_EchoThread) {
+        return;
+    }
+    std::this_thread::sleep_for(ECHO_DRAIN_PERIOD);
+    m_EchoStop = true;
+    JoinThread(m_EchoThread);
+    m_Rtt.Merge(m_IntervalRtt.Take());
+}
+
+/**
+ * @brief Take the echoes in: the round trip of one is the time it is dequeued minus the
+ *  Timestamp it was sent with, recorded for the period and for its stream, stamped after the
+ *  header (see StampStream). Polls, so that no wake up adds to the round trips. The hot thread
+ *  only sends on the request queue and this thread only receives, and RIO leaves each side to
+ *  a single thread, not both to the same one.
+ */
+void RioProducer::EchoWorker() {
+    PinThread(2, "Echo thread");
+    std::vector<RIORESULT> results(MAX_RIO_RESULTS);
+    while (!m_EchoStop.load(std::memory_order_relaxed)) {
+        const ULONG numResults = m_EchoTransport.Dequeue(results.data(), MAX_RIO_RESULTS);
+        if (RIO_CORRUPT_CQ == numResults) {
+            utilities::ErrorExit("RIODequeueCompletion");
+        }
+        if (numResults == 0) {
+            continue;
+        }
+        const uint64_t now = utilities::get_unix_time();
+        const StreamTable& streams = m_StreamTable.Acquire();
+        LatencyHistogram& period = m_IntervalRtt.BeginBatch();
+        for (ULONG i = 0; i < numResults; i++) {
+            const auto pHeader = reinterpret_cast<const ProtocolHeader_t*>(m_EchoSlot.Data(
+                m_EchoBuffPtr, static_cast<ULONG>(results[i].RequestContext)));
+            if (results[i].BytesTransferred >= STAMPED_HEADER_SIZE
+                && pHeader->Token == PROTOCOL_TOKEN
+                && streams.Find(StampedStream(pHeader)) != nullptr) {
+                const uint64_t rtt = now > pHeader->Timestamp ? now - pHeader->Timestamp : 0;
+                period.Record(rtt);
+                m_StreamRtt[StampedStream(pHeader)].Record(rtt);
+                m_Echoes++;
+            } else {
+                m_OtherEchoes++;
+            }
+            m_EchoTransport.Repost(results[i].RequestContext);
+        }
+        m_IntervalRtt.EndBatch();
+        m_StreamTable.Release();
+    }
+}
+
+/**
+ * @brief Print the round trips of the whole run, then the RTT_LIST_MAX streams with the highest
+ *  p99. A stream echoed by several reflectors has the echoes of all of them.
+ */
+void RioProducer::PrintRtt() const {
+    printf("\tEchoes: %llu for %llu packets sent, %llu other datagrams\n", m_Echoes,
+           static_cast<uint64_t>(m_TotalPkts.load()), m_OtherEchoes);
+    PrintLatency(m_Rtt, "Round trip");
+    if (m_StreamRtt.empty()) {
+        return;
+    }
+    std::vector<std::pair<StreamKey_t, const LatencyHistogram*>> rows;
+    for (const auto& [key, rtt] : m_StreamRtt) {
+        rows.emplace_back(key, &rtt);
+    }
+    std::stable_sort(rows.begin(), rows.end(), [](const auto& a, const auto& b) {
+        return a.second->Percentile(99) > b.second->Percentile(99);
+    });
+    printf("\n  Group:Port               Echoes    Min (us)    p50 (us)    p99 (us)    Max (us)\n");
+    const size_t listed = std::min(rows.size(), RTT_LIST_MAX);
+    for (size_t i = 0; i < listed; i++) {
+        const LatencyHistogram& rtt = *rows[i].second;
+        printf("  %-21s %10llu %11.1f %11.1f %11.1f %11.1f\n", StreamName(rows[i].first).c_str(),
+               rtt.Count(), rtt.Min() / 1e3, rtt.Percentile(50) / 1e3, rtt.Percentile(99) / 1e3,
+               rtt.Max() / 1e3);
+    }
+    if (listed < rows.size()) {
+        printf("  ... %zu more streams, none with a higher p99\n", rows.size() - listed);
+    }
+}
+
+void RioProducer::CleanUpRIO() {
+    RioSession::CleanUpRIO();
+    ReleaseAndDeregisterBuffer(m_EchoBuffId, m_EchoBuffPtr, m_EchoBuffSize);
+}
+
+/**
+ * @brief Tune the spin between rounds every 100ms and take a sample every report period (1s
+ *  unless --report_ms), which the printer thread prints. With --adapt_rate the consumer reports
+ *  are taken in on every tick and the rate adapted with every sample.
+ */
 void RioProducer::SpinWorker() {
+    PinThread(1, "Sampler thread");
+    StatsMerge merge;
     uint64_t PreviousN = 0;
+    uint64_t PreviousStalls = 0;
     uint64_t PreviousTuningN = 0;
-    int64_t ExpectedPPSDiv10 = (m_Args->PacketRate * m_NumberOfMcGroups) / 10;
-    int64_t DeltaThreashold = std::max((m_Args->PacketRate * m_NumberOfMcGroups) / 2000UL, 1UL);
-    auto NextReportTime = utilities::get_unix_time() + (uint64_t)1e9;
+    auto PreviousReportTime = utilities::get_unix_time();
+    auto NextReportTime = PreviousReportTime + m_ReportPeriodNs;
     auto NextTuningTime = utilities::get_unix_time() + (uint64_t)1e8;
+    // Wake up often enough for both the tuning and the reports
+    const auto Tick = std::min(std::chrono::nanoseconds(m_ReportPeriodNs),
+                               std::chrono::nanoseconds(std::chrono::milliseconds(100)));
     while (ShouldStop()) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        std::this_thread::sleep_for(Tick);
+        if (m_Feedback) {
+            while (m_Feedback->Receive(merge, SteadyNs())) {
+            }
+        }
         auto Now = utilities::get_unix_time();
         if (Now >= NextReportTime) {
-            auto ElapsedTime_ns = 1e9 + (double)(Now - NextReportTime);
-            auto ReportPeriod = ElapsedTime_ns / 1e9;
-            auto PacketDelta = (double)m_TotalPkts - (double)PreviousN;
-            PreviousN = m_TotalPkts.load();
-            std::cout << "Sent " << m_TotalPkts
-                      << " total packets, throughput: " << (PacketDelta / ReportPeriod)
-                      << " pkts/sec" << std::endl;
+            IntervalSample_t sample;
+            sample.TimeNs = Now;
+            sample.IntervalNs = Now - PreviousReportTime;
+            sample.TotalPackets = m_TotalPkts.load();
+            sample.Pps = (double)(sample.TotalPackets - PreviousN) * 1e9 / sample.IntervalNs;
+            auto Stalls = m_SendStalls.load();
+            sample.Stalls = Stalls - PreviousStalls;
+            if (m_Adapter) {
+                Adapt(merge, sample);
+            }
+            if (m_Args->Rtt) {
+                auto rtt = m_IntervalRtt.Take();
+                m_Rtt.Merge(rtt);
+                sample.LatencyP50Ns = rtt.Percentile(50);
+                sample.LatencyP99Ns = rtt.Percentile(99);
+                sample.LatencyMaxNs = rtt.Max();
+            }
+            m_Samples.TryPush(sample);
 
-            NextReportTime = utilities::get_unix_time() + (uint64_t)1e9;
+            PreviousReportTime = Now;
+            PreviousN = sample.TotalPackets;
+            PreviousStalls = Stalls;
+            NextReportTime += m_ReportPeriodNs;
+            if (NextReportTime <= Now) {
+                NextReportTime = Now + m_ReportPeriodNs;
+            }
         }
-        if (Now >= NextTuningTime) {
+        // There is no spin to tune at line rate nor when a profile paces the sends
+        if (!m_Args->LineRate && !m_Profile && Now >= NextTuningTime) {
             NextTuningTime = Now + (uint64_t)1e8;
+            // Streams and the rate can change live
+            const uint64_t ExpectedPPS = m_StreamRate.load() * m_ActiveStreams.load();
+            const int64_t ExpectedPPSDiv10 = ExpectedPPS / 10;
+            const int64_t DeltaThreashold = std::max<uint64_t>(ExpectedPPS / 2000, 1);
             auto PacketDelta = ((int64_t)m_TotalPkts.load() - (int64_t)PreviousTuningN) - ExpectedPPSDiv10;
             PreviousTuningN = m_TotalPkts.load();
+            if (m_Paused.load()) {
+                continue;  // Nothing sent, nothing to tune
+            }
             if (PacketDelta > DeltaThreashold) {
                 auto var =m_SpinDuration.load() ;
                 if ( var > 0) {
                     var += (PacketDelta / DeltaThreashold) * 10;
                 }
                 if ( var < 1000) {
-                    m_SpinDuration.store(100);
+                    m_SpinDuration.store(MIN_SPIN_NS);
                 }
                 else{
                     m_SpinDuration.store(var);
@@ -195,7 +596,7 @@ void RioProducer::SpinWorker() {
                 auto calc = (PacketDelta / DeltaThreashold) * 10;
                 calc += m_SpinDuration.load();
                 if ( calc < 1000 )
-                    m_SpinDuration.store(100);
+                    m_SpinDuration.store(MIN_SPIN_NS);
                 else
                     m_SpinDuration.store(calc);
             }
@@ -203,24 +604,233 @@ void RioProducer::SpinWorker() {
     }
 }
 
-void RioProducer::GroupStatsUpdate(const SOCKADDR_INET* addr,
-                                   const size_t pktSize,
-                                   const ProtocolHeader_t* pHdr) {
-    uint32_t mcGroup = addr->Ipv4.sin_addr.s_addr;
-    McGroupStats_t& gmc = m_GroupStats[mcGroup];
+/**
+ * @brief Judge the period that ends from the consumer reports and move the rate of every stream
+ *  where the adapter says, recording both in @p sample.
+ */
+void RioProducer::Adapt(StatsMerge& merge, IntervalSample_t& sample) {
+    const size_t streams = std::max<size_t>(m_ActiveStreams.load(), 1);
+    const AdaptStep_t step
+        = m_Adapter->Step(merge.Period(SteadyNs(), m_ReportPeriodNs), sample.Pps / streams);
+    if (step.Next != step.Rate) {
+        ApplyRate(step.Next);
+    }
+    sample.TargetPps = step.Rate;
+    sample.Verdict = static_cast<uint32_t>(step.Verdict);
+    sample.Receivers = step.Receivers;
+    sample.WorstLossPct = step.WorstLossPct;
+}
 
-    gmc.Sequence.store(gmc.Packets.load());  // Sequence is behind 1.
-    gmc.Packets++;
-    gmc.Bytes.fetch_add(pktSize);
+void RioProducer::PrintSample(const IntervalSample_t& sample, uint64_t) {
+    std::cout << "Sent " << sample.TotalPackets << " total packets, throughput: " << sample.Pps
+              << " pkts/sec";
+    if (m_Args->LineRate) {
+        std::cout << ", stalls: " << sample.Stalls;
+    }
+    if (m_Args->Rtt) {
+        std::cout << ", RTT us p50 " << sample.LatencyP50Ns / 1e3 << ", p99 "
+                  << sample.LatencyP99Ns / 1e3 << ", max " << sample.LatencyMaxNs / 1e3;
+    }
+    if (m_Adapter) {
+        std::cout << ", at " << sample.TargetPps << " pps per stream: "
+                  << AdaptVerdictName(static_cast<AdaptVerdict>(sample.Verdict));
+        if (sample.Receivers != 0) {
+            std::cout << " (" << sample.Receivers << " receivers, worst loss "
+                      << sample.WorstLossPct << "%)";
+        }
+    }
+    std::cout << std::endl;
+}
+
+/**
+ * @brief Live requests: add streams to or remove them from the constant rate sends, each group
+ *  (a --mcast_ip style address or range) on every port, and list the groups sent to.
+ */
+std::string RioProducer::Control(const std::vector<std::string>& words) {
+    const std::string& request = words.front();
+    if ((request == "add" || request == "remove") && words.size() == 2) {
+        if (m_Pcap || m_Profile) {
+            return "Error: streams are only added and removed at a constant rate, not with "
+                   "--pcap, --profile nor --rate_file";
+        }
+        if (m_Args->Unicast) {
+            return "Error: streams are only added and removed on multicast groups, not with "
+                   "--unicast";
+        }
+        const Ipv4Vect groups = ParseGroups(words[1]);
+        return request == "add" ? AddLive(groups) : RemoveLive(groups);
+    }
+    if (request == "groups" && words.size() == 1) {
+        return ListGroups();
+    }
+    if ((request == "pps" && words.size() == 2) || request == "pause" || request == "resume") {
+        if (m_Pcap || m_Profile || m_Args->LineRate) {
+            return "Error: the rate only changes at a constant rate, not with --pcap, --profile, "
+                   "--rate_file nor --line_rate";
+        }
+        if (request == "pps" && m_Adapter) {
+            return "Error: the rate is adapted to the consumer reports (--adapt_rate)";
+        }
+        return request == "pps" ? SetRate(words[1]) : SetPaused(request == "pause");
+    }
+    return RioSession::Control(words);
+}
+
+std::string RioProducer::ControlHelp() const {
+    return "add <groups>, remove <groups>, groups, pps <rate>, pause, resume";
+}
+
+/**
+ * @brief Send to the streams of @p groups from the next round on. A stream keeps the address
+ *  slot and the statistics it got the first time, so one removed and added again continues
+ *  where it was (its consumer sees the rounds it missed as drops). New ones take a free
+ *  slot among the LIVE_STREAM_SLOTS. Without --line_rate, streams are only added while the
+ *  total stays within MAX_PACKET_RATE at the current rate.
+ *
+ * @return std::string The reply
+ */
+std::string RioProducer::AddLive(const Ipv4Vect& groups) {
+    AddStreams(groups, m_Args->McastPorts);
+    auto streams = m_LiveStreams.Current();
+    const int64_t streamRate = m_StreamRate.load();
+    size_t added = 0;
+    size_t full = 0;
+    size_t capped = 0;
+    for (const auto group : groups) {
+        for (const auto port : m_Args->McastPorts) {
+            const auto key = MakeStreamKey(group.ipNetOrder(), htons(port));
+            if (std::any_of(streams.begin(), streams.end(),
+                            [key](const SendStream_t& s) { return s.Key == key; })) {
+                continue;
+            }
+            if (!m_Args->LineRate
+                && streamRate * static_cast<int64_t>(streams.size() + 1) > MAX_PACKET_RATE) {
+                capped++;
+                continue;
+            }
+            auto addrSlot = m_AddrSlotOf.find(key);
+            if (addrSlot == m_AddrSlotOf.end()) {
+                const auto slot = static_cast<DWORD>(m_AddrSlotOf.size());
+                if (slot == m_AddrSlots) {
+                    full++;
+                    continue;
+                }
+                SetStreamAddr(slot, key);
+                addrSlot = m_AddrSlotOf.emplace(key, slot).first;
+            }
+            streams.push_back(SendStream_t{key, addrSlot->second, &m_GroupStats.at(key)});
+            added++;
+        }
+    }
+    m_ActiveStreams = streams.size();
+    m_LiveStreams.Publish(std::move(streams));
+    std::string reply = "Added " + std::to_string(added) + " streams, sending to "
+                        + std::to_string(m_ActiveStreams.load());
+    if (full != 0) {
+        reply += ", " + std::to_string(full) + " not added: the " + std::to_string(m_AddrSlots)
+                 + " addresses are used";
+    }
+    if (capped != 0) {
+        reply += ", " + std::to_string(capped) + " not added: at most "
+                 + std::to_string(MAX_PACKET_RATE) + " pps over the streams";
+    }
+    return reply;
+}
+
+/**
+ * @brief Stop sending to the streams of @p groups from the next round on.
+ *
+ * @return std::string The reply
+ */
+std::string RioProducer::RemoveLive(const Ipv4Vect& groups) {
+    auto streams = m_LiveStreams.Current();
+    const size_t before = streams.size();
+    streams.erase(std::remove_if(streams.begin(), streams.end(),
+                                 [&groups](const SendStream_t& s) {
+                                     return std::any_of(groups.begin(), groups.end(),
+                                                        [&s](const auto& group) {
+                                                            return group.ipNetOrder()
+                                                                   == StreamGroup(s.Key);
+                                                        });
+                                 }),
+                  streams.end());
+    const size_t removed = before - streams.size();
+    m_ActiveStreams = streams.size();
+    m_LiveStreams.Publish(std::move(streams));
+    return "Removed " + std::to_string(removed) + " streams, sending to "
+           + std::to_string(m_ActiveStreams.load());
+}
+
+/**
+ * @brief The pps request: ApplyRate of @p rate.
+ *
+ * @return std::string The reply
+ */
+std::string RioProducer::SetRate(const std::string& rate) {
+    int64_t newRate = 0;
+    try {
+        newRate = std::stoll(rate);
+    } catch (const std::exception&) {
+        return "Error: packets per second of each stream expected, got " + rate;
+    }
+    if (newRate < 1) {
+        return "Error: the rate is at least 1 pps per stream";
+    }
+    if (newRate * m_ActiveStreams.load() > MAX_PACKET_RATE) {
+        return "Error: at most " + std::to_string(MAX_PACKET_RATE) + " pps over the "
+               + std::to_string(m_ActiveStreams.load()) + " streams";
+    }
+    const int64_t oldRate = ApplyRate(newRate);
+    return "Sending " + std::to_string(newRate) + " pps to each of the "
+           + std::to_string(m_ActiveStreams.load()) + " streams, was "
+           + std::to_string(oldRate);
+}
+
+/**
+ * @brief Send @p rate packets per second to every stream from now on. The spin between rounds
+ *  is scaled right away, and tuned from there as usual; the hot thread only ever reads it.
+ *
+ * @return int64_t The previous rate
+ */
+int64_t RioProducer::ApplyRate(int64_t rate) {
+    const int64_t oldRate = m_StreamRate.exchange(rate);
+    m_SpinDuration = std::max(m_SpinDuration.load() * oldRate / rate, MIN_SPIN_NS);
+    return oldRate;
+}
+
+/**
+ * @brief Stop the constant rate rounds, or go on with them. Sequences go on where they
+ *  stopped, so a consumer sees no drop across a pause.
+ *
+ * @return std::string The reply
+ */
+std::string RioProducer::SetPaused(bool paused) {
+    const bool was = m_Paused.exchange(paused);
+    if (was == paused) {
+        return paused ? "Already paused" : "Not paused";
+    }
+    return paused ? "Paused" : "Resumed";
+}
+
+std::string RioProducer::ListGroups() {
+    std::string reply = std::to_string(m_ActiveStreams.load()) + " streams";
+    size_t listed = 0;
+    for (const auto& stream : m_LiveStreams.Current()) {
+        if (listed++ == CONTROL_LIST_MAX) {
+            reply += " ...";
+            break;
+        }
+        reply += (listed == 1 ? ": " : ", ") + StreamName(stream.Key);
+    }
+    return reply;
 }
 
 void RioProducer::GroupStatsPrint() {
-    char inetspace[16];
-    std::cout << "\n  Group           Packets        Bytes      Last Seq   " << std::endl;
-    std::cout << "---------------------------------------------------------" << std::endl;
+    std::cout << "\n  Group:Port            Packets        Bytes      Last Seq" << std::endl;
+    std::cout << std::string(57, '-') << std::endl;
 
     for (auto const& [key, value] : m_GroupStats) {
-        std::cout << inet_ntop(AF_INET, &key, inetspace, INET_ADDRSTRLEN) << "\t" << std::dec
+        std::cout << std::left << std::setw(21) << StreamName(key) << std::right << std::dec
                   << std::setw(10) << value.Packets << "  " << std::setw(12) << value.Bytes << "  "
                   << std::setw(10) << value.Sequence << std::endl;
     }
@@ -1,24 +1,96 @@
 #include "RioSession.hpp"
+#include "PcapReader.hpp"
+#include "RateAdapter.hpp"
+#include "RioPolicies.hpp"
+#include "StatsAggregator.hpp"
+#include "TrafficProfile.hpp"
 
 namespace riosession {
 
+constexpr DWORD LIVE_STREAM_SLOTS = 1024;  // Addresses registered for streams added live
+constexpr auto PAUSE_POLL_PERIOD = std::chrono::milliseconds(1);
+constexpr int64_t MIN_SPIN_NS = 100;  // Floor of the tuned spin between rounds
+constexpr ULONG ECHO_RECVS = 16384;   // Receives preposted for the echoes of a reflector
+constexpr auto ECHO_DRAIN_PERIOD = std::chrono::milliseconds(100);  // After the last send
+constexpr size_t RTT_LIST_MAX = 32;   // Streams of the round trip table
+
+/**
+ * @brief Where a stream's packets go: its registered address and its statistics.
+ */
+struct SendStream_t {
+    StreamKey_t Key;
+    DWORD AddrSlot;
+    McGroupStats_t* Stats;
+};
+
 class RioProducer : public RioSession {
    private:
     void SendOnInterface(const std::string& iaddr);
-    void InitMcAddrDescriptors() override;
-    uint64_t PostFirstSend(DWORD totalMessages);
-    void GroupStatsUpdate(const SOCKADDR_INET* addr,
-                          const size_t pktSize,
-                          const ProtocolHeader_t* pHdr) override;
+    void InitMcAddrDescriptors();
+    void SetStreamAddr(DWORD addrSlot, StreamKey_t key);
     void GroupStatsPrint() override;
     void SpinWorker();
+    void PrintSample(const IntervalSample_t& sample, uint64_t index) override;
+    void InitSendRing(DWORD slotSize);
+    void InitReplay();
+    void ReplayCapture();
+    void SendProfile();
+    DWORD AcquireSendSlot();
+    void PostSend(DWORD slot, DWORD length, const SendStream_t& stream);
+    void ReapSendCompletions(bool wait);
+    void PrintResults();
+    void InitEchoRing();
+    void StartEchoes();
+    void StopEchoes();
+    void EchoWorker();
+    void PrintRtt() const;
+    std::string Control(const std::vector<std::string>& words) override;
+    std::string ControlHelp() const override;
+    std::string AddLive(const Ipv4Vect& groups);
+    std::string RemoveLive(const Ipv4Vect& groups);
+    std::string ListGroups();
+    std::string SetRate(const std::string& rate);
+    int64_t ApplyRate(int64_t rate);
+    void Adapt(StatsMerge& merge, IntervalSample_t& sample);
+    std::string SetPaused(bool paused);
 
    private:
     std::atomic_int64_t m_SpinDuration;
-    UINT m_NumberOfMcGroups;
+    std::atomic_int64_t m_StreamRate;  // --pps, changed by the pps request
+    std::atomic_bool m_Paused = false;
+    UINT m_NumberOfStreams;  // Groups times ports
+    DWORD m_AddrSlots;       // Registered addresses, room for the live streams with --control
+    std::vector<SendStream_t> m_Streams;  // Those of the arguments, by stream index
+    RcuValue<std::vector<SendStream_t>> m_LiveStreams;  // Those sent to at a constant rate
+    std::map<StreamKey_t, DWORD> m_AddrSlotOf;  // Address of every stream ever sent to
+    std::atomic<size_t> m_ActiveStreams = 0;
+    std::unique_ptr<PcapReader> m_Pcap;
+    std::unique_ptr<TrafficProfile> m_Profile;
+    DWORD m_SendSlotSize = 0;
+    std::vector<DWORD> m_FreeSlots;
+    std::unique_ptr<RIORESULT[]> m_SendResults;
+    std::atomic<uint64_t> m_SendStalls = 0;
+    std::unique_ptr<StatsListener> m_Feedback;  // Consumer reports, with --adapt_rate
+    std::unique_ptr<RateAdapter> m_Adapter;
+    RecvSlotLayout_t m_EchoSlot;  // The echo ring, with --rtt
+    char* m_EchoBuffPtr = nullptr;
+    RIO_BUFFERID m_EchoBuffId = NULL;
+    DWORD m_EchoBuffSize = 0;
+    RioRecvTransport m_EchoTransport;
+    UniqueThread_t m_EchoThread;
+    std::atomic_bool m_EchoStop = false;
+    IntervalHistogram m_IntervalRtt;  // Written by the echo thread
+    LatencyHistogram m_Rtt;           // Whole run, merged by the sampler
+    std::map<StreamKey_t, LatencyHistogram> m_StreamRtt;  // Echo thread, read once it stopped
+    uint64_t m_Echoes = 0;
+    uint64_t m_OtherEchoes = 0;  // Not echoes of this producer's packets
 
    public:
     void Start() override;
+    void CleanUpRIO() override;
+    const LatencyHistogram& Rtt() const {
+        return m_Rtt;
+    }
     RioProducer(args_t* args,  volatile sig_atomic_t* signal);
     ~RioProducer() = default;
 };
@@ -1,25 +1,62 @@
 #include "RioSession.hpp"
+// clang-format off
+#include <iomanip>
+#include <sstream>
+// clang-format on
 
 namespace riosession {
-RioSession::RioSession(args_t* args, volatile sig_atomic_t* signal)
+
+/**
+ * @brief Print a latency distribution: the one way latency, from the producer's Timestamp to
+ *  the dequeue of the completion, or the round trip of the echoes.
+ */
+void PrintLatency(const LatencyHistogram& latency, const char* name) {
+    printf("\t%s (us) over %llu packets: min %.1f, mean %.1f, p50 %.1f, p99 %.1f, "
+           "p99.9 %.1f, max %.1f\n",
+           name, latency.Count(), latency.Min() / 1e3, latency.Mean() / 1e3,
+           latency.Percentile(50) / 1e3, latency.Percentile(99) / 1e3,
+           latency.Percentile(99.9) / 1e3, latency.Max() / 1e3);
+}
+
+RioSession::RioSession(args_t* args, volatile sig_atomic_t* signal, double defaultReportSec)
     : m_Args(args), m_ExitSignal(signal) {
+    // Pin before anything is allocated so the CQ, descriptors and result arrays are
+    // first touched from the NIC's node
+    PinThread(0, "Hot thread");
     CreateSocket(WSA_FLAG_REGISTERED_IO);
     m_hIOCP = ::CreateIoCompletionPort(INVALID_HANDLE_VALUE, 0, 0, 0);
     m_TotalPkts = 0;
-    InitGroupStats(args->McastAddrStr);
+    m_LargePagesUsed = m_Args->LargePages;
+    InitGroupStats(args->McastAddrStr, args->McastPorts);
+    m_ReportPeriodNs = m_Args->ReportMs != 0 ? m_Args->ReportMs * 1000000ULL
+                                             : static_cast<uint64_t>(defaultReportSec * 1e9);
+    if (m_Args->StageReport) {
+        m_Stages.SetPeriod(m_ReportPeriodNs / 1000000);
+    }
 }
 
 /**
- * @brief Create the WSA Socket as a DGRAM for UDP.
+ * @brief Open a WSA Socket as a DGRAM for UDP.
  *
  * @param flags Default flags set to 0.
+ * @return SOCKET
  */
-void RioSession::CreateSocket(const DWORD flags) {
-    m_SocketHandle = ::WSASocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, flags);
+SOCKET RioSession::OpenSocket(const DWORD flags) const {
+    SOCKET socket = ::WSASocket(AF_INET, SOCK_DGRAM, IPPROTO_UDP, NULL, 0, flags);
 
-    if (m_SocketHandle == INVALID_SOCKET) {
+    if (socket == INVALID_SOCKET) {
         utilities::ErrorExit("WSASocket");
     }
+    return socket;
+}
+
+/**
+ * @brief Create the session's socket, see OpenSocket.
+ *
+ * @param flags Default flags set to 0.
+ */
+void RioSession::CreateSocket(const DWORD flags) {
+    m_SocketHandle = OpenSocket(flags);
 }
 
 void RioSession::InitializeRIO() {
@@ -41,6 +78,10 @@ void RioSession::InitializeRIO() {
  * @param bindPort
  */
 void RioSession::BindSocket(uint16_t bindPort, const std::string& bindAddr) {
+    BindSocket(m_SocketHandle, bindPort, bindAddr);
+}
+
+void RioSession::BindSocket(SOCKET socket, uint16_t bindPort, const std::string& bindAddr) {
     sockaddr_in addr;
 
     addr.sin_family = AF_INET;
@@ -56,7 +97,7 @@ void RioSession::BindSocket(uint16_t bindPort, const std::string& bindAddr) {
     }
 
     if (SOCKET_ERROR
-        == ::bind(m_SocketHandle, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr))) {
+        == ::bind(socket, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr))) {
         utilities::ErrorExit("Error during socket binding process");
     }
 }
@@ -66,33 +107,54 @@ void RioSession::BindSocket(uint16_t bindPort, const std::string& bindAddr) {
  *
  */
 void RioSession::CreateRequestQueue() {
-    m_RequestQueue = m_RioFuncTable.RIOCreateRequestQueue(
-        m_SocketHandle, m_MaxOutstandingReceive, m_MaxReceiveDataBuffers, m_MaxOutstandingSend,
-        m_MaxSendDataBuffers, m_CompletionQueue, m_CompletionQueue, NULL);
+    m_RequestQueue = CreateRequestQueue(m_SocketHandle, m_MaxOutstandingReceive);
+}
+
+/**
+ * @brief Create the Request queue of @p socket, with room for @p maxOutstandingReceive
+ *  receives, over the session's Completion queue.
+ *
+ * @param socket
+ * @param maxOutstandingReceive
+ * @return RIO_RQ
+ */
+RIO_RQ RioSession::CreateRequestQueue(SOCKET socket, ULONG maxOutstandingReceive) {
+    return CreateRequestQueue(socket, maxOutstandingReceive, m_CompletionQueue,
+                              m_CompletionQueue);
+}
 
-    if (m_RequestQueue == RIO_INVALID_RQ) {
+/**
+ * @brief Create the Request queue of @p socket, its receives completing on @p receiveQueue and
+ *  its m_MaxOutstandingSend sends on @p sendQueue.
+ */
+RIO_RQ RioSession::CreateRequestQueue(SOCKET socket,
+                                      ULONG maxOutstandingReceive,
+                                      RIO_CQ receiveQueue,
+                                      RIO_CQ sendQueue) {
+    RIO_RQ requestQueue = m_RioFuncTable.RIOCreateRequestQueue(
+        socket, maxOutstandingReceive, m_MaxReceiveDataBuffers, m_MaxOutstandingSend,
+        m_MaxSendDataBuffers, receiveQueue, sendQueue, NULL);
+
+    if (requestQueue == RIO_INVALID_RQ) {
         utilities::ErrorExit("Error creating a RIO Request Queue");
     }
+    return requestQueue;
 }
 
 char* RioSession::AllocateBufferSpace(const DWORD messageSize,
                                       const DWORD totalMessages,
                                       DWORD& bufferSize,
                                       DWORD& receiveBuffersAllocated) {
-    const DWORD preferredNumaNode = 0;
-
-    const SIZE_T largePageMinimum = LARGE_PAGES_ENABLED ? ::GetLargePageMinimum() : 0;
+    const SIZE_T largePageMinimum = m_Args->LargePages ? swxtch::sys::LargePageSize() : 0;
 
     SYSTEM_INFO systemInfo;
 
     ::GetSystemInfo(&systemInfo);
 
-    systemInfo.dwAllocationGranularity;
-
     const unsigned __int64 granularity
         = (largePageMinimum == 0 ? systemInfo.dwAllocationGranularity : largePageMinimum);
 
-    const unsigned __int64 desiredSize = messageSize * totalMessages;
+    const unsigned __int64 desiredSize = static_cast<unsigned __int64>(messageSize) * totalMessages;
 
     unsigned __int64 actualSize = utilities::RoundUp(desiredSize, granularity);
 
@@ -106,14 +168,15 @@ char* RioSession::AllocateBufferSpace(const DWORD messageSize,
     bufferSize = static_cast<DWORD>(actualSize);
 
     // MEM_COMMIT assures that the memory will be filled with zeroes
+    bool largePages = (largePageMinimum != 0);
     char* pBuffer = reinterpret_cast<char*>(
-        VirtualAllocExNuma(GetCurrentProcess(), 0, bufferSize,
-                           MEM_COMMIT | MEM_RESERVE | (largePageMinimum != 0 ? MEM_LARGE_PAGES : 0),
-                           PAGE_READWRITE, preferredNumaNode));
+        swxtch::sys::AllocateOnNode(bufferSize, m_Args->NumaNode, largePages));
 
     if (pBuffer == 0) {
         utilities::ErrorExit("VirtualAlloc");
     }
+    // Reported as used only if every buffer of the session got them
+    m_LargePagesUsed = m_LargePagesUsed && largePages;
 
     return pBuffer;
 }
@@ -121,17 +184,19 @@ char* RioSession::AllocateBufferSpace(const DWORD messageSize,
 /**
  * @brief Allocate a Buffer of expected size @param messageSize * @param totalMessages
  * register that buffer using the RIO API and @return a pointer to the buffer.
- *  Store on @param bufferId the ID that the RIO API has assigned to the buffer.
+ *  Store on @param bufferId the ID that the RIO API has assigned to the buffer and on
+ *  @param bufferSize the size actually allocated.
  *
  * @param messageSize
  * @param totalMessages
  * @param bufferId
+ * @param bufferSize
  * @return char*
  */
 char* RioSession::AllocateAndRegisterBuffer(const DWORD messageSize,
                                             const DWORD totalMessages,
-                                            RIO_BUFFERID& bufferId) {
-    DWORD bufferSize = 0;
+                                            RIO_BUFFERID& bufferId,
+                                            DWORD& bufferSize) {
     DWORD pendingRealSize = 0;
 
     auto bufferPointer
@@ -150,8 +215,11 @@ char* RioSession::AllocateAndRegisterBuffer(const DWORD messageSize,
 void RioSession::CleanUpRIO() {
     CloseSocket();
     m_RioFuncTable.RIOCloseCompletionQueue(m_CompletionQueue);
-    ReleaseAndDeregisterBuffer(m_RioBuffId, m_RioBuffPtr);
-    ReleaseAndDeregisterBuffer(m_McAddrBuffId, m_McAddrBuffPtr);
+    if (m_EchoQueue != RIO_INVALID_CQ) {
+        m_RioFuncTable.RIOCloseCompletionQueue(m_EchoQueue);
+    }
+    ReleaseAndDeregisterBuffer(m_RioBuffId, m_RioBuffPtr, m_RioBuffSize);
+    ReleaseAndDeregisterBuffer(m_McAddrBuffId, m_McAddrBuffPtr, m_McAddrBuffSize);
 }
 
 /**
@@ -168,9 +236,14 @@ void RioSession::CloseSocket() {
  * @brief De-allocates the packet memory buffer and De-register the buffer from RIO API.
  *
  */
-void RioSession::ReleaseAndDeregisterBuffer(RIO_BUFFERID& bufferId, char* buffPointer) {
+void RioSession::ReleaseAndDeregisterBuffer(RIO_BUFFERID& bufferId,
+                                            char* buffPointer,
+                                            DWORD bufferSize) {
+    if (buffPointer == nullptr) {
+        return;
+    }
     m_RioFuncTable.RIODeregisterBuffer(bufferId);
-    if (0 == VirtualFreeEx(GetCurrentProcess(), buffPointer, 0, MEM_RELEASE)) {
+    if (!swxtch::sys::FreeOnNode(buffPointer, bufferSize)) {
         utilities::ErrorExit("Error deAllocating the buffer");
     };
 }
@@ -193,6 +266,17 @@ void RioSession::CreateCompletionQueue(DWORD cqSize) {
     }
 }
 
+/**
+ * @brief Create a completion queue without notification, only ever dequeued in a loop.
+ */
+RIO_CQ RioSession::CreatePolledCompletionQueue(DWORD cqSize) {
+    RIO_CQ completionQueue = m_RioFuncTable.RIOCreateCompletionQueue(cqSize, NULL);
+    if (completionQueue == RIO_INVALID_CQ) {
+        utilities::ErrorExit("RIOCreateCompletionQueue");
+    }
+    return completionQueue;
+}
+
 /**
  * @brief Notify the completion Queue
  *
@@ -205,15 +289,51 @@ void RioSession::NotifyCompletionQueue() {
 }
 
 /**
- * @brief Init the Multicast Group Stats for each Multicast Group
- *  configured by the user
+ * @brief Init the Stats of each stream: every Multicast Group configured by the user on each
+ *  of the ports
  * @param mcastGroupAddr
+ * @param ports
  */
-void RioSession::InitGroupStats(const Ipv4Vect& mcastGroupAddr) {
+void RioSession::InitGroupStats(const Ipv4Vect& mcastGroupAddr,
+                                const std::vector<uint16_t>& ports) {
     for (const auto mcAddr : mcastGroupAddr) {
-        m_GroupStats.insert(
-            std::pair<uint32_t, McGroupStats_t>(mcAddr.ipNetOrder(), McGroupStats_t{}));
+        for (const auto port : ports) {
+            m_GroupStats.insert(std::pair<StreamKey_t, McGroupStats_t>(
+                MakeStreamKey(mcAddr.ipNetOrder(), htons(port)), McGroupStats_t{}));
+        }
+    }
+    m_StreamTable.Publish(StreamTable(m_GroupStats));
+}
+
+/**
+ * @brief Add the statistics of the streams of @p groups on @p ports that are not there yet,
+ *  while the hot thread runs: map entries never move, so the other streams are accounted as
+ *  usual meanwhile, and the hot thread looks the new ones up from its next batch on.
+ *
+ * @param groups
+ * @param ports
+ */
+void RioSession::AddStreams(const Ipv4Vect& groups, const std::vector<uint16_t>& ports) {
+    std::lock_guard<std::mutex> lock(m_GroupStatsLock);
+    for (const auto group : groups) {
+        for (const auto port : ports) {
+            m_GroupStats[MakeStreamKey(group.ipNetOrder(), htons(port))];
+        }
     }
+    m_StreamTable.Publish(StreamTable(m_GroupStats));
+}
+
+/**
+ * @brief "group:port" of a stream, for the statistics tables.
+ *
+ * @param key
+ * @return std::string
+ */
+std::string RioSession::StreamName(StreamKey_t key) {
+    char inetspace[INET_ADDRSTRLEN];
+    uint32_t group = StreamGroup(key);
+    inet_ntop(AF_INET, &group, inetspace, INET_ADDRSTRLEN);
+    return std::string(inetspace) + ":" + std::to_string(ntohs(StreamPort(key)));
 }
 
 /**
@@ -230,7 +350,8 @@ void RioSession::PrintTimings(ULONGLONG pktsProcessed, ULONGLONG pktsOther) {
     std::cout << "\tWith " << pktsOther << " other received packets" << std::endl;
     if (elapsedMs != 0) {
         const double perSec = pktsProcessed / (elapsedMs / 1000.00);
-        std::cout << "\t" << perSec << " datagrams per second" << std::endl;
+        std::cout << "\t" << perSec << " datagrams per second ("
+                  << (m_LargePagesUsed ? "large" : "regular") << " pages)" << std::endl;
     }
 }
 
@@ -261,4 +382,255 @@ void RioSession::JoinThread(UniqueThread_t& t) const {
     }
 }
 
+/**
+ * @brief Pin the calling thread to a processor of the configured NUMA node.
+ *  Slot 0 is the hot thread, slot 1 the sampler thread, both counted from args CoreSlot so
+ *  sessions sharing a process (search command) use different processors.
+ *
+ * @param slot
+ * @param name Printed along with the chosen processor
+ */
+void RioSession::PinThread(uint32_t slot, const char* name) const {
+    if (m_Args->NumaNode < 0) {
+        return;
+    }
+    auto cpu = swxtch::sys::PinCurrentThread(m_Args->NumaNode, m_Args->CoreSlot + slot);
+    if (cpu < 0) {
+        std::cout << name << " could not be pinned to NUMA node " << m_Args->NumaNode
+                  << std::endl;
+    } else {
+        std::cout << name << " pinned to CPU " << cpu << " on NUMA node " << m_Args->NumaNode
+                  << std::endl;
+    }
+}
+
+/**
+ * @brief Sampler side of the reports: sleep until @p due, then move it one report period
+ *  later. Due times are absolute so the intervals do not drift; a sampler that fell more than
+ *  a period behind starts over from now. Sleeps at most 100ms at a time to check the stop
+ *  conditions.
+ *
+ * @param due
+ * @return bool false when the session stops
+ */
+bool RioSession::WaitForSample(std::chrono::steady_clock::time_point& due) {
+    while (ShouldStop()) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= due) {
+            due += std::chrono::nanoseconds(m_ReportPeriodNs);
+            if (due <= now) {
+                due = now + std::chrono::nanoseconds(m_ReportPeriodNs);
+            }
+            return true;
+        }
+        std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+            due - now, std::chrono::milliseconds(100)));
+    }
+    return false;
+}
+
+/**
+ * @brief Start the thread printing the samples, see PrintWorker. The CSV export, when asked
+ *  for, is opened here and written by that thread only.
+ */
+void RioSession::StartPrinter() {
+    if (!m_Args->ReportCsv.empty()) {
+        m_ReportCsv = fopen(m_Args->ReportCsv.c_str(), "w");
+        if (m_ReportCsv == nullptr) {
+            utilities::ErrorExit("Error opening the report CSV file");
+        }
+        fprintf(m_ReportCsv,
+                "time_ns,interval_ns,total_pkts,total_ooo,total_missing,pps,bps,ooo,missing,"
+                "latency_p50_ns,latency_p99_ns,latency_max_ns,batch_mean,empty_batch_pct,"
+                "full_batch_pct,min_outstanding,overruns,stalls\n");
+    }
+    m_SamplingDone = false;
+    m_PrintThread = std::make_unique<std::thread>(&RioSession::PrintWorker, this);
+}
+
+/**
+ * @brief Print what the sampler left in the ring and stop the printer. Call once the sampler
+ *  thread is joined.
+ */
+void RioSession::StopPrinter() {
+    m_SamplingDone.store(true, std::memory_order_release);
+    JoinThread(m_PrintThread);
+    if (m_ReportCsv != nullptr) {
+        fclose(m_ReportCsv);
+        m_ReportCsv = nullptr;
+    }
+    if (m_Samples.Dropped() != 0) {
+        std::cout << "\t" << m_Samples.Dropped()
+                  << " report samples dropped, the printer fell behind" << std::endl;
+    }
+}
+
+/**
+ * @brief Printer side of the reports: drain the sample ring every PRINT_POLL_PERIOD. Console
+ *  and file output only ever slow this thread, never the sampler or the hot thread.
+ */
+void RioSession::PrintWorker() {
+    IntervalSample_t sample;
+    uint64_t index = 0;
+    bool done = false;
+    while (!done) {
+        done = m_SamplingDone.load(std::memory_order_acquire);
+        while (m_Samples.TryPop(sample)) {
+            PrintSample(sample, index++);
+            if (m_ReportCsv != nullptr) {
+                WriteCsvRow(sample);
+            }
+        }
+        fflush(stdout);
+        if (!done) {
+            std::this_thread::sleep_for(PRINT_POLL_PERIOD);
+        }
+    }
+}
+
+void RioSession::WriteCsvRow(const IntervalSample_t& sample) const {
+    fprintf(m_ReportCsv,
+            "%llu,%llu,%llu,%llu,%llu,%.1f,%.1f,%llu,%llu,%llu,%llu,%llu,%.2f,%.2f,%.2f,%llu,%llu,"
+            "%llu\n",
+            sample.TimeNs, sample.IntervalNs, sample.TotalPackets, sample.TotalOutOfOrder,
+            sample.TotalDrops, sample.Pps, sample.Bps, sample.OutOfOrder, sample.Drops,
+            sample.LatencyP50Ns, sample.LatencyP99Ns, sample.LatencyMaxNs, sample.BatchMean,
+            sample.EmptyBatchPct, sample.FullBatchPct, sample.MinOutstanding, sample.Overruns,
+            sample.Stalls);
+}
+
+/**
+ * @brief Start taking live requests from the --control channel, if any.
+ */
+void RioSession::StartControl() {
+    if (m_Args->Control == CONTROL_OFF) {
+        return;
+    }
+    m_Control = std::make_shared<ControlQueue>();
+    m_StatsBaselineTime = m_Timing.startTime;
+    if (m_Args->ControlPort != CONTROL_PORT_NONE) {
+        m_ControlSocket = std::make_unique<SocketControl>();
+        m_ControlSocket->Start(m_Control, m_Args->ControlPort);
+        std::cout << "Taking live requests on " << CONTROL_ADDRESS << ":" << m_Args->ControlPort
+                  << ". " << ControlRequests() << std::endl;
+    } else {
+        StartConsoleControl(m_Control);
+        std::cout << "Taking live requests from the console. " << ControlRequests()
+                  << std::endl;
+    }
+    m_ControlThread = std::make_unique<std::thread>(&RioSession::ControlWorker, this);
+}
+
+void RioSession::StopControl() {
+    JoinThread(m_ControlThread);
+    if (m_ControlSocket) {
+        m_ControlSocket->Stop();
+    }
+}
+
+/**
+ * @brief Execute the live requests one at a time, until the session stops. A request is a
+ *  line of words separated by spaces, see Control.
+ */
+void RioSession::ControlWorker() {
+    ControlRequest_t request;
+    while (ShouldStop()) {
+        if (!m_Control->Pop(request, CONTROL_POLL_PERIOD)) {
+            continue;
+        }
+        std::vector<std::string> words;
+        for (auto& word : swxtch::str::split(request.Line, ' ')) {
+            if (!swxtch::str::trim(word).empty()) {
+                words.push_back(word);
+            }
+        }
+        if (words.empty()) {
+            continue;
+        }
+        try {
+            request.Reply(Control(words));
+        } catch (const std::exception& ex) {
+            request.Reply(std::string("Error: ") + ex.what());
+        }
+    }
+}
+
+/**
+ * @brief Execute a live request. Sessions handle theirs and leave the others here.
+ *
+ * @param words The request, first word is its name
+ * @return std::string The reply
+ */
+std::string RioSession::Control(const std::vector<std::string>& words) {
+    const std::string& request = words.front();
+    if (request == "stats" && words.size() == 1) {
+        return StatsDump();
+    }
+    if (request == "reset" && words.size() == 1) {
+        return ResetStats();
+    }
+    if (request == "help") {
+        return ControlRequests();
+    }
+    return "Unknown request " + words.front() + ". " + ControlRequests();
+}
+
+std::string RioSession::ControlRequests() const {
+    return "Requests: " + ControlHelp() + ", stats, reset, help";
+}
+
+/**
+ * @brief Counters of every stream since the last reset request (the start of the session
+ *  before any), a line each after a line of totals. Drops can go down as out of order packets
+ *  fill gaps, so a stream's drops since the reset are clamped at 0.
+ *
+ * @return std::string The reply
+ */
+std::string RioSession::StatsDump() {
+    auto since = [](uint64_t now, uint64_t then) { return now - std::min(now, then); };
+    const McGroupStats_t none;
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                                         - m_StatsBaselineTime)
+                               .count();
+    TotalStats_t totals;
+    std::string streams;
+    std::lock_guard<std::mutex> lock(m_GroupStatsLock);
+    for (const auto& [key, stats] : m_GroupStats) {
+        const auto baseline = m_StatsBaseline.find(key);
+        const McGroupStats_t& then = baseline != m_StatsBaseline.end() ? baseline->second : none;
+        const uint64_t packets = since(stats.Packets.load(), then.Packets.load());
+        const uint64_t bytes = since(stats.Bytes.load(), then.Bytes.load());
+        const uint64_t drops = since(stats.RxDropped.load(), then.RxDropped.load());
+        const uint64_t outOfOrder = since(stats.OutOfOrder.load(), then.OutOfOrder.load());
+        totals.TotalPackets += packets;
+        totals.TotalBytes += bytes;
+        totals.TotalDrops += drops;
+        totals.TotalOutOfOrder += outOfOrder;
+        streams += "\n" + StreamName(key) + " packets " + std::to_string(packets) + " bytes "
+                   + std::to_string(bytes) + " drops " + std::to_string(drops)
+                   + " out_of_order " + std::to_string(outOfOrder);
+    }
+    std::ostringstream reply;
+    reply << m_GroupStats.size() << " streams over " << std::fixed << std::setprecision(1)
+          << seconds << " s: packets " << totals.TotalPackets << " ("
+          << (seconds > 0 ? totals.TotalPackets / seconds : 0.0) << " pps) bytes "
+          << totals.TotalBytes << " drops " << totals.TotalDrops << " out_of_order "
+          << totals.TotalOutOfOrder << streams;
+    return reply.str();
+}
+
+/**
+ * @brief Start the counters of the stats request over. The hot thread's counters are not
+ *  touched, as the sequence tracking relies on them: a copy is kept to count from.
+ *
+ * @return std::string The reply
+ */
+std::string RioSession::ResetStats() {
+    std::lock_guard<std::mutex> lock(m_GroupStatsLock);
+    m_StatsBaseline = m_GroupStats;
+    m_StatsBaselineTime = std::chrono::steady_clock::now();
+    return "Counters of the " + std::to_string(m_StatsBaseline.size())
+           + " streams reset, the reports keep counting from the start";
+}
+
 }  // namespace riosession
@@ -8,74 +8,37 @@
 #include <atomic>
 #include <algorithm>
 #include <memory>
+#include <mutex>
 #include "Utilities.hpp"
 #include "args.hpp"
 #include "StringUtils.hpp"
+#include "SystemUtils.hpp"
+#include "GroupStats.hpp"
+#include "RecvSlot.hpp"
+#include "RecvProcessor.hpp"
+#include "StageProbes.hpp"
+#include "SampleRing.hpp"
+#include "RcuValue.hpp"
+#include "ControlChannel.hpp"
 
 // clang-format on
 
 namespace riosession {
 
-constexpr bool LARGE_PAGES_ENABLED = false;
-constexpr DWORD EXPECTED_DATA_SIZE = 100;     // Expected payload size
 constexpr ULONG MAX_PENDING_RECVS = 1500000;  // Choose a multiple of 65536
+constexpr ULONG MIN_PENDING_RECVS = 4096;
+constexpr ULONG MIN_SOCKET_RECVS = 256;  // Floor of each socket's share of the receive ring
+constexpr uint64_t MAX_REGISTERED_BUFFER = 0xFFE00000;  // DWORD max, rounded down to 2 MB pages
 constexpr ULONG MAX_PENDING_SENDS = 4000;
-constexpr DWORD MAX_RIO_RESULTS = 1000;
-constexpr DWORD ADDR_SIZE = sizeof(SOCKADDR_INET);
-constexpr double REPORT_PERIOD_SEC = 4.0;
+constexpr double REPORT_PERIOD_SEC = 4.0;  // Consumer default, --report_ms overrides
+constexpr double PRODUCER_REPORT_PERIOD_SEC = 1.0;
+constexpr size_t SAMPLE_RING_SIZE = 4096;  // 40s of samples at the shortest report interval
+constexpr auto PRINT_POLL_PERIOD = std::chrono::milliseconds(20);
 
-#pragma pack(push, 1)
-struct ProtocolHeader_t {
-    uint16_t Token;
-    uint8_t CmdType;
-    uint8_t Tag;
-    uint64_t Seq;
-    uint64_t Timestamp;
-};
-#pragma pack(pop)
-
-struct McGroupStats_t {
-    std::atomic<uint64_t> Packets;
-    std::atomic<uint64_t> Bytes;
-    std::atomic<uint64_t> Sequence;
-    std::atomic<uint64_t> ExpectedSequence;
-    std::atomic<uint64_t> OutOfOrder;
-    std::atomic<uint64_t> RxDropped;
-
-    McGroupStats_t()
-        : Packets(0), Bytes(0), Sequence(0), ExpectedSequence(0), OutOfOrder(0), RxDropped(0) {
-    }
-
-    McGroupStats_t(const McGroupStats_t& other) {
-        Packets.store(other.Packets.load());
-        Bytes.store(other.Bytes.load());
-        Sequence.store(other.Sequence.load());
-        ExpectedSequence.store(other.ExpectedSequence.load());
-        OutOfOrder.store(other.OutOfOrder.load());
-        RxDropped.store(other.RxDropped.load());
-    }
-
-    McGroupStats_t& operator=(const McGroupStats_t& other) {
-        Packets.store(other.Packets.load());
-        Bytes.store(other.Bytes.load());
-        Sequence.store(other.Sequence.load());
-        ExpectedSequence.store(other.ExpectedSequence.load());
-        OutOfOrder.store(other.OutOfOrder.load());
-        RxDropped.store(other.RxDropped.load());
-        return *this;
-    }
-};
-
-struct TotalStats_t {
-    uint64_t TotalPackets = 0;
-    uint64_t TotalBytes = 0;
-    uint64_t TotalOutOfOrder = 0;
-    uint64_t TotalDrops = 0;
-};
-
-using McGroupStatsMap = std::map<uint32_t, struct McGroupStats_t>;
 using UniqueThread_t = std::unique_ptr<std::thread>;
 
+void PrintLatency(const LatencyHistogram& latency, const char* name = "Latency");
+
 struct Timing_s {
     std::chrono::steady_clock::time_point startTime;
     std::chrono::steady_clock::time_point stopTime;
@@ -102,11 +65,13 @@ class RioSession {
     SOCKET m_SocketHandle;
     RIO_RQ m_RequestQueue;
     RIO_CQ m_CompletionQueue;
+    RIO_CQ m_EchoQueue = RIO_INVALID_CQ;  // Polled: the reflector's sends, the --rtt receives
     char* m_RioBuffPtr = nullptr;
     RIO_BUFFERID m_RioBuffId = NULL;
-    std::unique_ptr<RIO_BUF[]> m_RioBuffDescr;
+    DWORD m_RioBuffSize = 0;
     char* m_McAddrBuffPtr = nullptr;
     RIO_BUFFERID m_McAddrBuffId = NULL;
+    DWORD m_McAddrBuffSize = 0;
     std::unique_ptr<RIO_BUF[]> m_McAddrDescr;
     RIO_EXTENSION_FUNCTION_TABLE m_RioFuncTable;
     HANDLE m_hIOCP;
@@ -117,40 +82,80 @@ class RioSession {
     args_t* m_Args;
     Timing_s m_Timing;
     volatile sig_atomic_t* m_ExitSignal;
-    McGroupStatsMap m_GroupStats;
+    McGroupStatsMap m_GroupStats;  // Entries are added in place, never moved nor removed
+    std::mutex m_GroupStatsLock;   // Adding entries, and walking them next to a control thread
+    RcuValue<StreamTable> m_StreamTable;  // Lookups of the hot thread
     std::atomic_ulong m_TotalPkts;
+    bool m_LargePagesUsed;
     UniqueThread_t m_ReportThread;
+    UniqueThread_t m_PrintThread;
+    StageProfile m_Stages;  // Empty unless built with RIO_STAGE_PROBES
+    uint64_t m_ReportPeriodNs;
+    SpscRing<IntervalSample_t, SAMPLE_RING_SIZE> m_Samples;
+    std::atomic_bool m_SamplingDone = false;
+    FILE* m_ReportCsv = nullptr;
+    std::shared_ptr<ControlQueue> m_Control;  // With --control
+    UniqueThread_t m_ControlThread;
+    std::unique_ptr<SocketControl> m_ControlSocket;  // With --control <port>
+    McGroupStatsMap m_StatsBaseline;  // Counters at the last reset request, control thread only
+    std::chrono::steady_clock::time_point m_StatsBaselineTime;
 
    protected:
+    SOCKET OpenSocket(const DWORD flags = 0) const;
     void CreateSocket(const DWORD flags = 0);
     void InitializeRIO();
     void CloseSocket();
     void BindSocket(uint16_t bindPort, const std::string& bindAddr);
-    void ReleaseAndDeregisterBuffer(RIO_BUFFERID& bufferId, char* buffPointer);
+    void BindSocket(SOCKET socket, uint16_t bindPort, const std::string& bindAddr);
+    void ReleaseAndDeregisterBuffer(RIO_BUFFERID& bufferId, char* buffPointer, DWORD bufferSize);
     char* AllocateBufferSpace(const DWORD messageSize,
                               const DWORD totalMessages,
                               DWORD& bufferSize,
                               DWORD& receiveBuffersAllocated);
     char* AllocateAndRegisterBuffer(const DWORD messageSize,
                                     const DWORD totalMessages,
-                                    RIO_BUFFERID& bufferId);
+                                    RIO_BUFFERID& bufferId,
+                                    DWORD& bufferSize);
     void CreateCompletionQueue(DWORD cqSize);
     void CreateRequestQueue();
+    RIO_RQ CreateRequestQueue(SOCKET socket, ULONG maxOutstandingReceive);
+    RIO_RQ CreateRequestQueue(SOCKET socket,
+                              ULONG maxOutstandingReceive,
+                              RIO_CQ receiveQueue,
+                              RIO_CQ sendQueue);
+    RIO_CQ CreatePolledCompletionQueue(DWORD cqSize);
     void NotifyCompletionQueue();
-    void InitGroupStats(const Ipv4Vect& mcastGroupAddr);
+    void InitGroupStats(const Ipv4Vect& mcastGroupAddr, const std::vector<uint16_t>& ports);
+    void AddStreams(const Ipv4Vect& groups, const std::vector<uint16_t>& ports);
     void PrintTimings(ULONGLONG pktsProcessed, ULONGLONG pktsOther);
-    virtual void GroupStatsUpdate(const SOCKADDR_INET* addr,
-                                  const size_t pktSize,
-                                  const ProtocolHeader_t* pHdr)
-        = 0;
     virtual void GroupStatsPrint() = 0;
-    virtual void InitMcAddrDescriptors() = 0;
     bool ShouldStop();
     void JoinThread(UniqueThread_t& t) const;
+    void PinThread(uint32_t slot, const char* name) const;
+    bool WaitForSample(std::chrono::steady_clock::time_point& due);
+    void StartPrinter();
+    void StopPrinter();
+    void PrintWorker();
+    void WriteCsvRow(const IntervalSample_t& sample) const;
+    virtual void PrintSample(const IntervalSample_t& sample, uint64_t index) = 0;
+    void StartControl();
+    void StopControl();
+    void ControlWorker();
+    virtual std::string Control(const std::vector<std::string>& words);
+    virtual std::string ControlHelp() const = 0;
+    std::string ControlRequests() const;
+    std::string StatsDump();
+    std::string ResetStats();
 
    public:
+    static std::string StreamName(StreamKey_t key);
     virtual void Start() = 0;
-    RioSession(args_t* args, volatile sig_atomic_t* signal);
+    uint64_t TotalPackets() const {
+        return m_TotalPkts.load();
+    }
+    RioSession(args_t* args,
+               volatile sig_atomic_t* signal,
+               double defaultReportSec = REPORT_PERIOD_SEC);
     virtual void CleanUpRIO();
     ~RioSession() = default;
 };
@@ -0,0 +1,82 @@
+#pragma once
+// clang-format off
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+// clang-format on
+
+namespace riosession {
+
+/**
+ * @brief One report interval of a session, taken by its sampler thread.
+ *  Producer sessions leave the receive side fields at 0 and fill Stalls.
+ */
+struct IntervalSample_t {
+    uint64_t TimeNs = 0;  // Unix time at the end of the interval
+    uint64_t IntervalNs = 0;
+    uint64_t TotalPackets = 0;
+    uint64_t TotalOutOfOrder = 0;
+    uint64_t TotalDrops = 0;
+    double Pps = 0;
+    double Bps = 0;
+    uint64_t OutOfOrder = 0;
+    uint64_t Drops = 0;
+    uint64_t LatencyP50Ns = 0;
+    uint64_t LatencyP99Ns = 0;
+    uint64_t LatencyMaxNs = 0;
+    double BatchMean = 0;
+    double EmptyBatchPct = 0;
+    double FullBatchPct = 0;
+    uint64_t MinOutstanding = 0;
+    uint64_t Overruns = 0;
+    uint64_t Stalls = 0;
+    uint64_t TargetPps = 0;  // Of each stream over the interval, producer --adapt_rate
+    uint32_t Verdict = 0;    // AdaptVerdict of the interval
+    uint64_t Receivers = 0;  // That reported traffic over the interval
+    double WorstLossPct = 0;
+};
+
+/**
+ * @brief Bounded lock-free single producer, single consumer ring. The sampler pushes, the
+ *  printer pops; neither ever waits for the other. When the printer falls behind, new samples
+ *  are dropped (and counted) rather than blocking the sampler.
+ */
+template <typename T, size_t N>
+class SpscRing {
+    static_assert((N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+   public:
+    bool TryPush(const T& item) {
+        const uint64_t head = m_Head.load(std::memory_order_relaxed);
+        if (head - m_Tail.load(std::memory_order_acquire) == N) {
+            m_Dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_Items[head & (N - 1)] = item;
+        m_Head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool TryPop(T& item) {
+        const uint64_t tail = m_Tail.load(std::memory_order_relaxed);
+        if (tail == m_Head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = m_Items[tail & (N - 1)];
+        m_Tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint64_t Dropped() const {
+        return m_Dropped.load(std::memory_order_relaxed);
+    }
+
+   private:
+    std::unique_ptr<T[]> m_Items = std::make_unique<T[]>(N);  // Off the session's stack
+    alignas(64) std::atomic<uint64_t> m_Head = 0;  // Written by the producer only
+    alignas(64) std::atomic<uint64_t> m_Tail = 0;  // Written by the consumer only
+    alignas(64) std::atomic<uint64_t> m_Dropped = 0;
+};
+
+}  // namespace riosession
@@ -0,0 +1,38 @@
+#include "SelfTest.hpp"
+#include "LoopbackRunner.hpp"
+
+namespace riosession {
+
+bool SelfTest::Start() {
+    args_t producerArgs = *m_Args;
+    producerArgs.PktsToCount = 0;
+    producerArgs.SecondsToRun = m_Args->SecondsToRun ? m_Args->SecondsToRun : SELFTEST_SEC;
+
+    args_t consumerArgs = *m_Args;
+    consumerArgs.ExpectedPacketRate
+        = static_cast<uint64_t>(m_Args->PacketRate) * m_Args->Streams();
+    consumerArgs.MeasureLatency = true;
+    consumerArgs.ChurnRate = CHURN_RATE_OFF;
+
+    auto result = LoopbackRunner(m_ExitSignal).Run(producerArgs, consumerArgs);
+
+    const double seconds = result.SendMs / 1000.0;
+    const double pps = seconds > 0 ? result.Received.TotalPackets / seconds : 0.0;
+    const uint64_t lost = result.Lost();
+    const bool passed = result.Sent > 0 && lost == 0;
+    printf("\nSelf test: %d bytes payload, %zu groups x %zu ports, %d pps per stream, %.1f s\n",
+           m_Args->PayloadSize, m_Args->McastAddrStr.size(), m_Args->McastPorts.size(),
+           m_Args->PacketRate, seconds);
+    printf("\tThroughput: %.0f pps, %.1f Mbps\n", pps, pps * m_Args->PayloadSize * 8 / 1e6);
+    printf("\tLoss: sent %llu, received %llu, lost %llu (%.4f%%), out of order %llu\n",
+           result.Sent, result.Received.TotalPackets, lost,
+           result.Sent ? 100.0 * lost / result.Sent : 0.0, result.Received.TotalOutOfOrder);
+    PrintLatency(result.Latency);
+    if (m_Args->Rtt) {
+        PrintLatency(result.Rtt, "Round trip");
+    }
+    printf("Self test %s\n", passed ? "PASSED" : "FAILED");
+    return passed;
+}
+
+}  // namespace riosession
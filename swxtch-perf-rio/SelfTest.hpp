@@ -0,0 +1,32 @@
+#pragma once
+// clang-format off
+#include <signal.h>
+#include "args.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr int SELFTEST_SEC = 10;  // When --seconds is 0
+
+/**
+ * @brief One command regression check of the whole hot path with no second host: a producer
+ * sends --pps per group of --payload_size datagrams for --seconds (SELFTEST_SEC if 0) to a
+ * consumer in this process (see LoopbackRunner), and the throughput, loss and one way latency
+ * are printed together. With --rtt the consumer is a reflector and the round trip is printed
+ * too.
+ */
+class SelfTest {
+   public:
+    SelfTest(args_t* args, volatile sig_atomic_t* signal) : m_Args(args), m_ExitSignal(signal) {
+    }
+    /**
+     * @return bool true when every packet sent was received
+     */
+    bool Start();
+
+   private:
+    args_t* m_Args;
+    volatile sig_atomic_t* m_ExitSignal;
+};
+
+}  // namespace riosession
@@ -0,0 +1,148 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <stdio.h>
+#include <array>
+#include <chrono>
+#include <thread>
+#if defined _MSC_VER
+    #include <intrin.h>
+#elif defined __x86_64__ || defined __i386__
+    #include <x86intrin.h>
+#endif
+#include "Histogram.hpp"
+// clang-format on
+
+/**
+ * Per stage cycle probes of the hot loops. They only exist in builds configured with
+ * -DRIO_STAGE_PROBES=ON: otherwise StageProfile is empty and every call below is an empty
+ * inline function, so the loops compile exactly as without them.
+ */
+namespace riosession {
+
+#if defined RIO_STAGE_PROBES
+constexpr bool STAGE_PROBES = true;
+#else
+constexpr bool STAGE_PROBES = false;
+#endif
+
+enum class Stage : uint32_t { Notify, Wait, Dequeue, Process, Post, Spin, Count };
+
+constexpr std::array<const char*, static_cast<size_t>(Stage::Count)> STAGE_NAMES{
+    "notify", "wait", "dequeue", "process", "repost/send", "spin"};
+
+/**
+ * @brief Histogram of the TSC cycles spent in each stage of one hot thread. A stage is timed
+ *  from the previous Mark (or Now) of the thread to its own Mark, so consecutive stages cost
+ *  one rdtsc each. With a period set, the hot thread itself prints and resets the period
+ *  histograms once per period; nothing is shared with other threads.
+ */
+class StageProfile {
+   public:
+#if defined RIO_STAGE_PROBES
+    static inline uint64_t Now() {
+        return __rdtsc();
+    }
+
+    inline void Mark(Stage stage, uint64_t& tsc) {
+        const uint64_t now = __rdtsc();
+        m_Total[static_cast<size_t>(stage)].Record(now - tsc);
+        if (m_PeriodTicks != 0) {
+            m_Period[static_cast<size_t>(stage)].Record(now - tsc);
+        }
+        tsc = now;
+    }
+
+    /**
+     * @brief Print and reset the period histograms if a period elapsed. Call from the hot thread
+     *  between batches.
+     */
+    inline void EndOfBatch(const char* title) {
+        if (m_PeriodTicks == 0) {
+            return;
+        }
+        const uint64_t now = __rdtsc();
+        if (now - m_PeriodStart >= m_PeriodTicks) {
+            Print(title, m_Period);
+            m_Period = {};
+            m_PeriodStart = now;
+        }
+    }
+
+    /**
+     * @brief Also report every @p periodMs milliseconds, 0 for the totals at shutdown only.
+     */
+    void SetPeriod(uint64_t periodMs) {
+        m_PeriodTicks = static_cast<uint64_t>(periodMs * TicksPerNs() * 1e6);
+        m_PeriodStart = __rdtsc();
+    }
+
+    void PrintTotals(const char* title) const {
+        Print(title, m_Total);
+    }
+#else
+    static inline uint64_t Now() {
+        return 0;
+    }
+    inline void Mark(Stage, uint64_t&) {
+    }
+    inline void EndOfBatch(const char*) {
+    }
+    void SetPeriod(uint64_t) {
+    }
+    void PrintTotals(const char*) const {
+    }
+#endif
+
+   private:
+#if defined RIO_STAGE_PROBES
+    using Histograms_t = std::array<LatencyHistogram, static_cast<size_t>(Stage::Count)>;
+
+    /**
+     * @brief TSC ticks per nanosecond, measured once against the steady clock.
+     */
+    static double TicksPerNs() {
+        static const double ticksPerNs = []() {
+            auto start = std::chrono::steady_clock::now();
+            const uint64_t tsc = __rdtsc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            const uint64_t ticks = __rdtsc() - tsc;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+            return static_cast<double>(ticks) / ns;
+        }();
+        return ticksPerNs;
+    }
+
+    static void Print(const char* title, const Histograms_t& stages) {
+        double totalCycles = 0;
+        for (const auto& stage : stages) {
+            totalCycles += stage.Mean() * stage.Count();
+        }
+        printf("\t%s stage cycles (TSC %.2f GHz):\n", title, TicksPerNs());
+        printf("\t  %-12s %12s %10s %10s %10s %10s %10s %7s\n", "stage", "count", "mean", "p50",
+               "p99", "p99.9", "max", "share");
+        for (size_t i = 0; i < stages.size(); i++) {
+            const auto& stage = stages[i];
+            if (stage.Count() == 0) {
+                continue;
+            }
+            printf("\t  %-12s %12llu %10.1f %10llu %10llu %10llu %10llu %6.1f%%\n",
+                   STAGE_NAMES[i], static_cast<unsigned long long>(stage.Count()), stage.Mean(),
+                   static_cast<unsigned long long>(stage.Percentile(50)),
+                   static_cast<unsigned long long>(stage.Percentile(99)),
+                   static_cast<unsigned long long>(stage.Percentile(99.9)),
+                   static_cast<unsigned long long>(stage.Max()),
+                   totalCycles > 0 ? 100.0 * stage.Mean() * stage.Count() / totalCycles : 0.0);
+        }
+    }
+
+    Histograms_t m_Total;
+    Histograms_t m_Period;
+    uint64_t m_PeriodTicks = 0;
+    uint64_t m_PeriodStart = 0;
+#endif
+};
+
+}  // namespace riosession
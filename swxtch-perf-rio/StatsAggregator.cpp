@@ -0,0 +1,157 @@
+#include "StatsAggregator.hpp"
+// clang-format off
+#include <stdio.h>
+#include "RioSession.hpp"
+#include "Utilities.hpp"
+// clang-format on
+
+namespace riosession {
+
+static sockaddr_in AggregatorAddress(const std::string& address, uint16_t port) {
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (address.empty()) {
+        addr.sin_addr.s_addr = INADDR_ANY;
+    } else if (inet_pton(AF_INET, address.c_str(), &addr.sin_addr.s_addr) != 1) {
+        utilities::ErrorExit("Error converting the aggregator address");
+    }
+    return addr;
+}
+
+StatsPublisher::StatsPublisher(const std::string& address, uint16_t port)
+    : m_To(AggregatorAddress(address, port)) {
+    m_Socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_Socket == INVALID_SOCKET) {
+        utilities::ErrorExit("Error opening the aggregator socket");
+    }
+    char host[STATS_RECEIVER_NAME] = {};
+    if (::gethostname(host, sizeof(host) - 1) != 0) {
+        strncpy(host, "unknown", sizeof(host) - 1);
+    }
+    m_Receiver = std::string(host) + ":" + std::to_string(::GetCurrentProcessId());
+}
+
+StatsPublisher::~StatsPublisher() {
+    ::closesocket(m_Socket);
+}
+
+void StatsPublisher::Publish(const McGroupStatsMap& groupStats,
+                             std::mutex& lock,
+                             const RingHealth_t& health) {
+    std::vector<std::string> datagrams;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        datagrams = EncodeStatsReport(m_Receiver, m_Sequence, health, groupStats);
+    }
+    for (const auto& datagram : datagrams) {
+        ::sendto(m_Socket, datagram.data(), static_cast<int>(datagram.size()), 0,
+                 reinterpret_cast<const sockaddr*>(&m_To), sizeof(m_To));
+    }
+}
+
+StatsListener::StatsListener(const std::string& address, uint16_t port, DWORD timeoutMs)
+    : m_Datagram(STATS_REPORT_MAX_BYTES) {
+    m_Socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (m_Socket == INVALID_SOCKET) {
+        utilities::ErrorExit("Error opening the aggregator socket");
+    }
+    sockaddr_in addr = AggregatorAddress(address, port);
+    if (SOCKET_ERROR == ::bind(m_Socket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))) {
+        utilities::ErrorExit("Error binding the aggregator socket");
+    }
+    if (timeoutMs == 0) {
+        u_long nonBlocking = 1;
+        ::ioctlsocket(m_Socket, FIONBIO, &nonBlocking);
+    } else {
+        ::setsockopt(m_Socket, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<char*>(&timeoutMs),
+                     sizeof(timeoutMs));
+    }
+}
+
+StatsListener::~StatsListener() {
+    ::closesocket(m_Socket);
+}
+
+bool StatsListener::Receive(StatsMerge& merge, uint64_t nowNs) {
+    const int size = ::recvfrom(m_Socket, m_Datagram.data(), static_cast<int>(m_Datagram.size()),
+                                0, nullptr, nullptr);
+    if (size <= 0) {
+        return false;
+    }
+    if (DecodeStatsReport(m_Datagram.data(), size, m_Header, m_Entries)) {
+        merge.Add(m_Header, m_Entries, nowNs);
+    } else {
+        m_Rejected++;
+    }
+    return true;
+}
+
+void StatsAggregator::Start() {
+    // The receive wakes up to print the periods and check the stop conditions
+    StatsListener listener(m_Args->Aggregator, m_Args->AggregatorPort,
+                           AGGREGATOR_RECV_TIMEOUT_MS);
+    const uint64_t periodNs = m_Args->ReportMs != REPORT_MS_AUTO
+                                  ? m_Args->ReportMs * 1000000ULL
+                                  : static_cast<uint64_t>(REPORT_PERIOD_SEC * 1e9);
+    printf("Aggregating the consumer reports sent to %s:%u, every %.1f s\n",
+           m_Args->Aggregator.empty() ? "*" : m_Args->Aggregator.c_str(),
+           m_Args->AggregatorPort, periodNs / 1e9);
+
+    const uint64_t startNs = SteadyNs();
+    uint64_t due = startNs + periodNs;
+    StatsMerge merge;
+    while (*m_ExitSignal == 0
+           && (m_Args->SecondsToRun == 0
+               || SteadyNs() - startNs < m_Args->SecondsToRun * utilities::ONE_SECOND)) {
+        listener.Receive(merge, SteadyNs());
+        if (SteadyNs() >= due) {
+            PrintPeriod(merge.Period(SteadyNs(), periodNs), listener.Rejected());
+            due += periodNs;
+        }
+    }
+}
+
+void StatsAggregator::PrintPeriod(const MergedPeriod_t& merged, uint64_t rejected) const {
+    printf("\n%zu receivers, %zu streams", merged.Receivers.size(), merged.Streams.size());
+    if (rejected != 0) {
+        printf(", %llu datagrams that were not reports", rejected);
+    }
+    printf("\n");
+    if (merged.Receivers.empty()) {
+        return;
+    }
+    printf("  Receiver                      Streams      Packets          PPS       Drops"
+           "   OutOfOrder   Loss %%  Lost  Overruns  Ring free %%\n");
+    printf("%s\n", std::string(129, '-').c_str());
+    for (size_t i = 0; i < merged.Receivers.size(); i++) {
+        const ReceiverPeriod_t& row = merged.Receivers[i];
+        printf("%c %-28.28s %7zu %12llu %12.1f %11llu %12llu %8.3f %5llu %9llu %12u",
+               i == merged.Worst ? '*' : ' ', row.Receiver.c_str(), row.Streams,
+               row.Counters.Packets, row.Pps, row.Counters.Drops, row.Counters.OutOfOrder,
+               row.LossPct, row.LostReports, row.Overruns, row.RingFreePct);
+        if (row.SilentNs != 0) {
+            printf("  silent for %.0f s", row.SilentNs / 1e9);
+        } else if (i == merged.Worst) {
+            printf("  <== worst");
+        }
+        printf("\n");
+    }
+
+    printf("\n  Group:Port            Receivers      Packets      Min PPS       Drops"
+           "   Worst receiver                Loss %%\n");
+    printf("%s\n", std::string(106, '-').c_str());
+    for (size_t i = 0; i < merged.Streams.size() && i < AGGREGATE_STREAM_ROWS; i++) {
+        const StreamPeriod_t& row = merged.Streams[i];
+        printf("  %-21s %9zu %12llu %12.1f %11llu   %-28.28s %8.3f\n",
+               RioSession::StreamName(row.Stream).c_str(), row.Receivers, row.Packets,
+               row.MinPps, row.Drops, row.Worst.c_str(), row.WorstLossPct);
+    }
+    if (merged.Streams.size() > AGGREGATE_STREAM_ROWS) {
+        printf("  ... %zu more streams, none worse\n",
+               merged.Streams.size() - AGGREGATE_STREAM_ROWS);
+    }
+    fflush(stdout);
+}
+
+}  // namespace riosession
@@ -0,0 +1,110 @@
+#pragma once
+// clang-format off
+#include "stdafx.h"
+#include <signal.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "args.hpp"
+#include "StatsReport.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr size_t AGGREGATE_STREAM_ROWS = 16;  // Worst streams printed each period
+constexpr DWORD AGGREGATOR_RECV_TIMEOUT_MS = 100;
+
+/**
+ * @brief Consumer side of the aggregation: push the counters of every stream to the
+ *  --aggregator address once per report period, as a few datagrams (see StatsReport.hpp). The
+ *  receiver is named after the host and the process, so several consumers can run on one host.
+ */
+class StatsPublisher {
+   public:
+    StatsPublisher(const std::string& address, uint16_t port);
+    ~StatsPublisher();
+    StatsPublisher(const StatsPublisher&) = delete;
+    StatsPublisher& operator=(const StatsPublisher&) = delete;
+
+    /**
+     * @brief Encode @p groupStats under @p lock, which guards adding streams, and send the
+     *  report once it is released. A datagram that cannot be sent is left for the next period.
+     */
+    void Publish(const McGroupStatsMap& groupStats,
+                 std::mutex& lock,
+                 const RingHealth_t& health);
+
+    const std::string& Receiver() const {
+        return m_Receiver;
+    }
+
+   private:
+    SOCKET m_Socket;
+    sockaddr_in m_To;
+    std::string m_Receiver;
+    uint64_t m_Sequence = 0;
+};
+
+/**
+ * @brief Receiving side of the reports, for the aggregate command and the producer's rate
+ *  adaptation: a UDP socket bound to the --aggregator address.
+ */
+class StatsListener {
+   public:
+    /**
+     * @param timeoutMs Longest wait of Receive, 0 for none
+     */
+    StatsListener(const std::string& address, uint16_t port, DWORD timeoutMs);
+    ~StatsListener();
+    StatsListener(const StatsListener&) = delete;
+    StatsListener& operator=(const StatsListener&) = delete;
+
+    /**
+     * @brief Add the next report datagram to @p merge, arrived at @p nowNs.
+     * @return bool false when none came within the timeout
+     */
+    bool Receive(StatsMerge& merge, uint64_t nowNs);
+
+    uint64_t Rejected() const {
+        return m_Rejected;
+    }
+
+   private:
+    SOCKET m_Socket;
+    std::vector<char> m_Datagram;
+    StatsReportHeader_t m_Header;
+    std::vector<StatsReportEntry_t> m_Entries;
+    uint64_t m_Rejected = 0;  // Datagrams that were not reports
+};
+
+/**
+ * @brief Nanoseconds of the steady clock, the time base of StatsMerge.
+ */
+inline uint64_t SteadyNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+/**
+ * @brief The aggregate command: receive the reports of many consumers on --aggregator and print,
+ *  every report period (4 s unless --report_ms), one row per receiver and one per stream of the
+ *  worst ones, with the worst receiver overall and of each stream called out. Runs until
+ *  CTRL-C or --seconds.
+ */
+class StatsAggregator {
+   public:
+    StatsAggregator(args_t* args, volatile sig_atomic_t* signal)
+        : m_Args(args), m_ExitSignal(signal) {
+    }
+    void Start();
+
+   private:
+    void PrintPeriod(const MergedPeriod_t& merged, uint64_t rejected) const;
+
+    args_t* m_Args;
+    volatile sig_atomic_t* m_ExitSignal;
+};
+
+}  // namespace riosession
@@ -0,0 +1,322 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+#include "GroupStats.hpp"
+// clang-format on
+
+/**
+ * Statistics a consumer pushes to the aggregator every report period, and the aggregator's
+ * merge of them. Free of Windows dependencies, like GroupStats.hpp.
+ */
+namespace riosession {
+
+constexpr uint32_t STATS_REPORT_MAGIC = 0x534F4952;  // "RIOS"
+constexpr uint16_t STATS_REPORT_VERSION = 2;  // 2 added the receive ring health
+constexpr size_t STATS_REPORT_MAX_BYTES = 1400;  // One datagram under a 1500 bytes MTU
+constexpr size_t STATS_RECEIVER_NAME = 64;
+constexpr uint64_t SILENT_PERIODS = 3;  // Periods without a report before a receiver is silent
+constexpr uint64_t REORDER_WINDOW = 64;  // Datagrams further behind come from a restarted receiver
+
+/**
+ * @brief A datagram of a receiver's report. Counters are cumulative since the receiver started,
+ *  so a lost datagram only delays the streams it carried until the next period. Fields are in
+ *  host order: the consumers and the aggregator all run on x86.
+ */
+#pragma pack(push, 1)
+struct StatsReportHeader_t {
+    uint32_t Magic;
+    uint16_t Version;
+    uint16_t Entries;
+    char Receiver[STATS_RECEIVER_NAME];  // Host and process id, NUL terminated
+    uint64_t Sequence;                   // Of the datagram, to count the lost ones
+    uint64_t Overruns;                   // Times the receive ring ran dry, cumulative
+    uint32_t RingFreePct;  // Fewest receives still posted over the last period, % of the ring
+};
+
+struct StatsReportEntry_t {
+    StreamKey_t Stream;
+    uint64_t Packets;
+    uint64_t Bytes;
+    uint64_t Drops;
+    uint64_t OutOfOrder;
+};
+#pragma pack(pop)
+
+constexpr size_t STATS_REPORT_ENTRIES
+    = (STATS_REPORT_MAX_BYTES - sizeof(StatsReportHeader_t)) / sizeof(StatsReportEntry_t);
+
+/**
+ * @brief How close a receiver's ring came to running dry, sent along with its counters: the
+ *  backlog the loss does not show yet.
+ */
+struct RingHealth_t {
+    uint64_t Overruns = 0;
+    uint32_t RingFreePct = 100;
+};
+
+/**
+ * @brief The datagrams of one report of every stream of @p groupStats.
+ *
+ * @param sequence Of the first datagram, moved past the last one
+ */
+inline std::vector<std::string> EncodeStatsReport(const std::string& receiver,
+                                                  uint64_t& sequence,
+                                                  const RingHealth_t& health,
+                                                  const McGroupStatsMap& groupStats) {
+    std::vector<std::string> datagrams;
+    std::vector<StatsReportEntry_t> entries;
+    entries.reserve(STATS_REPORT_ENTRIES);
+    auto flush = [&]() {
+        StatsReportHeader_t header{};
+        header.Magic = STATS_REPORT_MAGIC;
+        header.Version = STATS_REPORT_VERSION;
+        header.Entries = static_cast<uint16_t>(entries.size());
+        strncpy(header.Receiver, receiver.c_str(), STATS_RECEIVER_NAME - 1);
+        header.Sequence = sequence++;
+        header.Overruns = health.Overruns;
+        header.RingFreePct = health.RingFreePct;
+        std::string datagram(reinterpret_cast<const char*>(&header), sizeof(header));
+        datagram.append(reinterpret_cast<const char*>(entries.data()),
+                        entries.size() * sizeof(StatsReportEntry_t));
+        datagrams.push_back(std::move(datagram));
+        entries.clear();
+    };
+    for (const auto& [key, stats] : groupStats) {
+        entries.push_back(StatsReportEntry_t{key, stats.Packets.load(), stats.Bytes.load(),
+                                             stats.RxDropped.load(), stats.OutOfOrder.load()});
+        if (entries.size() == STATS_REPORT_ENTRIES) {
+            flush();
+        }
+    }
+    if (!entries.empty() || datagrams.empty()) {
+        flush();
+    }
+    return datagrams;
+}
+
+/**
+ * @return bool false for a datagram that is not a report of this version
+ */
+inline bool DecodeStatsReport(const char* data,
+                              size_t size,
+                              StatsReportHeader_t& header,
+                              std::vector<StatsReportEntry_t>& entries) {
+    if (size < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, data, sizeof(header));
+    header.Receiver[STATS_RECEIVER_NAME - 1] = '\0';
+    if (header.Magic != STATS_REPORT_MAGIC || header.Version != STATS_REPORT_VERSION
+        || size != sizeof(header) + header.Entries * sizeof(StatsReportEntry_t)) {
+        return false;
+    }
+    entries.resize(header.Entries);
+    memcpy(entries.data(), data + sizeof(header), header.Entries * sizeof(StatsReportEntry_t));
+    return true;
+}
+
+struct StreamCounters_t {
+    uint64_t Packets = 0;
+    uint64_t Bytes = 0;
+    uint64_t Drops = 0;
+    uint64_t OutOfOrder = 0;
+};
+
+/**
+ * @brief Percentage of the packets sent that a receiver missed.
+ */
+inline double LossPct(uint64_t packets, uint64_t drops) {
+    return packets + drops != 0 ? 100.0 * drops / (packets + drops) : 0.0;
+}
+
+/**
+ * @brief A receiver over the last period, all its streams added up.
+ */
+struct ReceiverPeriod_t {
+    std::string Receiver;
+    size_t Streams = 0;
+    StreamCounters_t Counters;
+    double Pps = 0;
+    double LossPct = 0;
+    uint64_t SilentNs = 0;     // Since its last report, when it missed SILENT_PERIODS
+    uint64_t LostReports = 0;  // Datagrams lost since it started
+    uint64_t Overruns = 0;       // Over the period
+    uint32_t RingFreePct = 100;  // Lowest reported over the period
+};
+
+/**
+ * @brief A stream over the last period, over all the receivers that reported it.
+ */
+struct StreamPeriod_t {
+    StreamKey_t Stream = 0;
+    size_t Receivers = 0;
+    uint64_t Packets = 0;  // Added up
+    uint64_t Drops = 0;    // Added up
+    double MinPps = 0;
+    std::string Worst;  // Receiver with the highest loss, the fewest packets among equals
+    double WorstLossPct = 0;
+    uint64_t WorstPackets = 0;
+};
+
+struct MergedPeriod_t {
+    uint64_t PeriodNs = 0;
+    std::vector<ReceiverPeriod_t> Receivers;  // In name order
+    std::vector<StreamPeriod_t> Streams;      // Worst first
+    size_t Worst = SIZE_MAX;                  // Index in Receivers, SIZE_MAX without any
+};
+
+/**
+ * @brief Highest loss first, then the fewest packets: at equal loss the slowest receiver is the
+ *  worst one.
+ */
+inline bool WorseThan(double lossA, uint64_t packetsA, double lossB, uint64_t packetsB) {
+    return lossA != lossB ? lossA > lossB : packetsA < packetsB;
+}
+
+/**
+ * @brief The aggregator's view of every receiver heard from: the latest cumulative counters of
+ *  each of its streams, and those of the previous period to take the deltas from.
+ */
+class StatsMerge {
+   public:
+    void Add(const StatsReportHeader_t& header,
+             const std::vector<StatsReportEntry_t>& entries,
+             uint64_t nowNs) {
+        Receiver_t& receiver = m_Receivers[header.Receiver];
+        if (receiver.HeardNs == 0) {
+            receiver.PeriodStartNs = nowNs;
+            receiver.PreviousOverruns = header.Overruns;
+        } else if (header.Sequence > receiver.NextSequence) {
+            receiver.LostReports += header.Sequence - receiver.NextSequence;
+        }
+        receiver.NextSequence = std::max(receiver.NextSequence, header.Sequence + 1);
+        receiver.HeardNs = nowNs;
+        receiver.Overruns = std::max(receiver.Overruns, header.Overruns);
+        receiver.RingFreePct = std::min(receiver.RingFreePct, header.RingFreePct);
+        for (const auto& entry : entries) {
+            // Counters of a datagram that arrived after a later one are stale
+            auto [latest, first] = receiver.Sequences.try_emplace(entry.Stream, header.Sequence);
+            if (!first && header.Sequence < latest->second
+                && latest->second - header.Sequence <= REORDER_WINDOW) {
+                continue;
+            }
+            latest->second = header.Sequence;
+            const StreamCounters_t counters{entry.Packets, entry.Bytes, entry.Drops,
+                                            entry.OutOfOrder};
+            // A stream's first counters are where it starts from, whatever came before
+            if (receiver.Now.emplace(entry.Stream, counters).second) {
+                receiver.Previous.emplace(entry.Stream, counters);
+            } else {
+                receiver.Now[entry.Stream] = counters;
+            }
+        }
+    }
+
+    /**
+     * @brief Close the period ending at @p nowNs: the deltas of every receiver and stream since
+     *  the previous one. A receiver's rates are over the time between its reports, the
+     *  aggregator's period only decides when they are taken.
+     */
+    MergedPeriod_t Period(uint64_t nowNs, uint64_t periodNs) {
+        MergedPeriod_t merged;
+        merged.PeriodNs = periodNs;
+        std::map<StreamKey_t, StreamPeriod_t> streams;
+        for (auto& [name, receiver] : m_Receivers) {
+            ReceiverPeriod_t row;
+            row.Receiver = name;
+            row.Streams = receiver.Now.size();
+            row.LostReports = receiver.LostReports;
+            if (nowNs - receiver.HeardNs > SILENT_PERIODS * periodNs) {
+                row.SilentNs = nowNs - receiver.HeardNs;
+            }
+            const uint64_t spanNs = receiver.HeardNs - receiver.PeriodStartNs;
+            for (const auto& [key, now] : receiver.Now) {
+                const StreamCounters_t delta = Since(now, receiver.Previous[key]);
+                row.Counters.Packets += delta.Packets;
+                row.Counters.Bytes += delta.Bytes;
+                row.Counters.Drops += delta.Drops;
+                row.Counters.OutOfOrder += delta.OutOfOrder;
+
+                const double pps = spanNs != 0 ? delta.Packets * 1e9 / spanNs : 0.0;
+                const double loss = LossPct(delta.Packets, delta.Drops);
+                StreamPeriod_t& stream = streams[key];
+                if (stream.Receivers == 0
+                    || WorseThan(loss, delta.Packets, stream.WorstLossPct, stream.WorstPackets)) {
+                    stream.Worst = name;
+                    stream.WorstLossPct = loss;
+                    stream.WorstPackets = delta.Packets;
+                }
+                stream.MinPps = stream.Receivers == 0 ? pps : std::min(stream.MinPps, pps);
+                stream.Stream = key;
+                stream.Receivers++;
+                stream.Packets += delta.Packets;
+                stream.Drops += delta.Drops;
+            }
+            row.Pps = spanNs != 0 ? row.Counters.Packets * 1e9 / spanNs : 0.0;
+            row.LossPct = LossPct(row.Counters.Packets, row.Counters.Drops);
+            row.Overruns = receiver.Overruns - receiver.PreviousOverruns;
+            row.RingFreePct = receiver.RingFreePct;
+            receiver.Previous = receiver.Now;
+            receiver.PeriodStartNs = receiver.HeardNs;
+            receiver.PreviousOverruns = receiver.Overruns;
+            receiver.RingFreePct = 100;
+
+            const size_t index = merged.Receivers.size();
+            if (merged.Worst == SIZE_MAX
+                || WorseThan(row.LossPct, row.Counters.Packets,
+                             merged.Receivers[merged.Worst].LossPct,
+                             merged.Receivers[merged.Worst].Counters.Packets)) {
+                merged.Worst = index;
+            }
+            merged.Receivers.push_back(std::move(row));
+        }
+        for (auto& [key, stream] : streams) {
+            merged.Streams.push_back(std::move(stream));
+        }
+        std::stable_sort(merged.Streams.begin(), merged.Streams.end(),
+                         [](const StreamPeriod_t& a, const StreamPeriod_t& b) {
+                             return WorseThan(a.WorstLossPct, a.Packets, b.WorstLossPct,
+                                              b.Packets);
+                         });
+        return merged;
+    }
+
+    size_t Receivers() const {
+        return m_Receivers.size();
+    }
+
+   private:
+    struct Receiver_t {
+        std::map<StreamKey_t, StreamCounters_t> Now;
+        std::map<StreamKey_t, StreamCounters_t> Previous;
+        std::map<StreamKey_t, uint64_t> Sequences;  // Datagram of each stream's counters in Now
+        uint64_t HeardNs = 0;        // Arrival of its latest datagram
+        uint64_t PeriodStartNs = 0;  // Arrival of its latest datagram of the previous period
+        uint64_t NextSequence = 0;
+        uint64_t LostReports = 0;
+        uint64_t Overruns = 0;
+        uint64_t PreviousOverruns = 0;
+        uint32_t RingFreePct = 100;
+    };
+
+    /**
+     * @brief Counters gained since @p then. Drops can go down as late packets fill gaps, a
+     *  receiver that restarted under the same name starts over: both clamp at 0.
+     */
+    static StreamCounters_t Since(const StreamCounters_t& now, const StreamCounters_t& then) {
+        auto since = [](uint64_t a, uint64_t b) { return a - std::min(a, b); };
+        return StreamCounters_t{since(now.Packets, then.Packets), since(now.Bytes, then.Bytes),
+                                since(now.Drops, then.Drops),
+                                since(now.OutOfOrder, then.OutOfOrder)};
+    }
+
+    std::map<std::string, Receiver_t> m_Receivers;
+};
+
+}  // namespace riosession
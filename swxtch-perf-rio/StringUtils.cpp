@@ -1,7 +1,7 @@
 #include <cmath>
 #include <cfenv>
 
-#include "stringUtils.hpp"
+#include "StringUtils.hpp"
 
 namespace swxtch {
 namespace str {
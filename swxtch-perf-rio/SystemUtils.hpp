@@ -0,0 +1,271 @@
+#pragma once
+
+// clang-format off
+#if defined _WINDOWS
+    #include "swxtch-win.hpp"
+    #include <Windows.h>
+    #include <initguid.h>
+    #include <devguid.h>
+    #include <devpkey.h>
+    #include <SetupAPI.h>
+    #pragma comment(lib, "setupapi")
+    #pragma comment(lib, "advapi32")
+#else
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <fstream>
+#endif
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <sstream>
+// clang-format on
+
+/**
+ * Host topology helpers: NUMA node discovery, thread pinning and node local allocations,
+ * optionally backed by large pages.
+ * A node of -1 means "unknown", in which case nothing is pinned and memory has no preference.
+ */
+namespace swxtch {
+namespace sys {
+
+/**
+ * @brief List the logical processors that belong to a NUMA node, in ascending order.
+ */
+inline std::vector<uint32_t> NodeProcessors(int node) {
+    std::vector<uint32_t> cpus;
+    if (node < 0) {
+        return cpus;
+    }
+#if defined _WINDOWS
+    GROUP_AFFINITY affinity{};
+    if (!::GetNumaNodeProcessorMaskEx(static_cast<USHORT>(node), &affinity)) {
+        return cpus;
+    }
+    for (uint32_t bit = 0; bit < sizeof(KAFFINITY) * 8; bit++) {
+        if (affinity.Mask & (static_cast<KAFFINITY>(1) << bit)) {
+            // Processor numbers are global: group * 64 + bit
+            cpus.push_back(affinity.Group * 64u + bit);
+        }
+    }
+#else
+    // cpulist format: "0-7,16-23"
+    std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+    std::string item;
+    while (std::getline(f, item, ',')) {
+        auto dash = item.find('-');
+        uint32_t from = std::stoul(item.substr(0, dash));
+        uint32_t till = (dash == std::string::npos) ? from : std::stoul(item.substr(dash + 1));
+        for (uint32_t cpu = from; cpu <= till; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+#endif
+    return cpus;
+}
+
+/**
+ * @brief Pin the calling thread to one processor of a NUMA node.
+ *
+ * @param node NUMA node
+ * @param slot Which processor of the node, counted from its first one. Wraps around.
+ * @return int The processor the thread was pinned to, -1 if it could not be pinned.
+ */
+inline int PinCurrentThread(int node, uint32_t slot) {
+    auto cpus = NodeProcessors(node);
+    if (cpus.empty()) {
+        return -1;
+    }
+    uint32_t cpu = cpus[slot % cpus.size()];
+#if defined _WINDOWS
+    GROUP_AFFINITY affinity{};
+    affinity.Group = static_cast<WORD>(cpu / 64);
+    affinity.Mask = static_cast<KAFFINITY>(1) << (cpu % 64);
+    if (!::SetThreadGroupAffinity(::GetCurrentThread(), &affinity, NULL)) {
+        return -1;
+    }
+#else
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        return -1;
+    }
+#endif
+    return static_cast<int>(cpu);
+}
+
+/**
+ * @brief Find the NUMA node the NIC is attached to.
+ *
+ * @param adapterName Adapter GUID name on Windows ("{...}"), interface name on Linux
+ * @return int NUMA node, -1 if unknown (single node hosts usually report none)
+ */
+inline int NicNumaNode(const std::string& adapterName) {
+    int node = -1;
+#if defined _WINDOWS
+    HDEVINFO devs = ::SetupDiGetClassDevsW(&GUID_DEVCLASS_NET, NULL, NULL, DIGCF_PRESENT);
+    if (devs == INVALID_HANDLE_VALUE) {
+        return node;
+    }
+    std::wstring wName(adapterName.begin(), adapterName.end());
+    SP_DEVINFO_DATA info;
+    info.cbSize = sizeof(info);
+    // Match the adapter through the NetCfgInstanceId of its driver key
+    for (DWORD i = 0; ::SetupDiEnumDeviceInfo(devs, i, &info); i++) {
+        HKEY key = ::SetupDiOpenDevRegKey(devs, &info, DICS_FLAG_GLOBAL, 0, DIREG_DRV, KEY_READ);
+        if (key == INVALID_HANDLE_VALUE) {
+            continue;
+        }
+        wchar_t cfgId[64];
+        DWORD size = sizeof(cfgId);
+        auto status
+            = ::RegGetValueW(key, NULL, L"NetCfgInstanceId", RRF_RT_REG_SZ, NULL, cfgId, &size);
+        ::RegCloseKey(key);
+        if (status != ERROR_SUCCESS || _wcsicmp(cfgId, wName.c_str()) != 0) {
+            continue;
+        }
+        DEVPROPTYPE type;
+        INT32 value = -1;
+        if (::SetupDiGetDevicePropertyW(devs, &info, &DEVPKEY_Numa_Node, &type,
+                                        reinterpret_cast<PBYTE>(&value), sizeof(value), NULL, 0)
+            && type == DEVPROP_TYPE_INT32) {
+            node = value;
+        }
+        break;
+    }
+    ::SetupDiDestroyDeviceInfoList(devs);
+#else
+    std::ifstream f("/sys/class/net/" + adapterName + "/device/numa_node");
+    if (!(f >> node)) {
+        node = -1;
+    }
+#endif
+    return node;
+}
+
+/**
+ * @brief Size of a large page, 0 if the host does not support them.
+ */
+inline size_t LargePageSize() {
+#if defined _WINDOWS
+    return ::GetLargePageMinimum();
+#else
+    std::ifstream f("/proc/meminfo");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.rfind("Hugepagesize:", 0) == 0) {
+            return std::stoul(line.substr(13)) * 1024;
+        }
+    }
+    return 0;
+#endif
+}
+
+/**
+ * @brief Make large page allocations possible for this process. On Windows that requires
+ * SeLockMemoryPrivilege ("Lock pages in memory") to be granted to the user; it is enabled on
+ * the process token here. On Linux it only checks hugetlbfs support: whether the pool has free
+ * pages is only known when allocating.
+ *
+ * @return bool false if large pages cannot be used
+ */
+inline bool EnableLargePages() {
+#if defined _WINDOWS
+    HANDLE token;
+    if (!::OpenProcessToken(::GetCurrentProcess(), TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY,
+                            &token)) {
+        return false;
+    }
+    TOKEN_PRIVILEGES privileges;
+    privileges.PrivilegeCount = 1;
+    privileges.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+    // AdjustTokenPrivileges succeeds with ERROR_NOT_ALL_ASSIGNED when the privilege is not held
+    bool enabled
+        = ::LookupPrivilegeValueW(NULL, SE_LOCK_MEMORY_NAME, &privileges.Privileges[0].Luid)
+          && ::AdjustTokenPrivileges(token, FALSE, &privileges, 0, NULL, NULL)
+          && ::GetLastError() == ERROR_SUCCESS;
+    ::CloseHandle(token);
+    return enabled && LargePageSize() != 0;
+#else
+    return LargePageSize() != 0;
+#endif
+}
+
+constexpr int MAX_NUMA_NODES = 256;  // Nodes a node mask of AllocateOnNode holds
+
+/**
+ * @brief Allocate zeroed, committed memory with its physical pages on a NUMA node.
+ *
+ * @param size bytes, multiple of the allocation granularity (of LargePageSize() for large pages)
+ * @param node NUMA node, -1 for no preference
+ * @param largePages In: try large pages first. Out: whether large pages were obtained. When they
+ * cannot be obtained the allocation silently falls back to regular pages.
+ * @return void* nullptr on failure
+ */
+inline void* AllocateOnNode(size_t size, int node, bool& largePages) {
+#if defined _WINDOWS
+    DWORD preferredNode = (node < 0) ? NUMA_NO_PREFERRED_NODE : static_cast<DWORD>(node);
+    if (largePages) {
+        void* p = ::VirtualAllocExNuma(::GetCurrentProcess(), NULL, size,
+                                       MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, PAGE_READWRITE,
+                                       preferredNode);
+        if (p) {
+            return p;
+        }
+        largePages = false;
+    }
+    return ::VirtualAllocExNuma(::GetCurrentProcess(), NULL, size, MEM_COMMIT | MEM_RESERVE,
+                                PAGE_READWRITE, preferredNode);
+#else
+    void* p = MAP_FAILED;
+    if (largePages) {
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB,
+                 -1, 0);
+    }
+    if (p == MAP_FAILED) {
+        bool transparent = largePages;
+        largePages = false;
+        p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            return nullptr;
+        }
+        if (transparent) {
+            // No hugetlbfs pages left: ask for transparent huge pages instead
+            madvise(p, size, MADV_HUGEPAGE);
+        }
+    }
+    if (node >= 0 && node < MAX_NUMA_NODES) {
+        // MPOL_PREFERRED: fall back to other nodes instead of failing when the node is full
+        constexpr int MPOL_PREFERRED = 1;
+        unsigned long nodeMask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = {};
+        nodeMask[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+        syscall(SYS_mbind, p, size, MPOL_PREFERRED, nodeMask, sizeof(nodeMask) * 8, 0);
+    }
+    return p;
+#endif
+}
+
+inline void* AllocateOnNode(size_t size, int node) {
+    bool largePages = false;
+    return AllocateOnNode(size, node, largePages);
+}
+
+/**
+ * @brief Release memory obtained with AllocateOnNode.
+ *
+ * @return bool false on failure
+ */
+inline bool FreeOnNode(void* p, size_t size) {
+#if defined _WINDOWS
+    return ::VirtualFreeEx(::GetCurrentProcess(), p, 0, MEM_RELEASE) != 0;
+#else
+    return munmap(p, size) == 0;
+#endif
+}
+
+}  // namespace sys
+}  // namespace swxtch
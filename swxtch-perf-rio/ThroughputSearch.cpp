@@ -0,0 +1,108 @@
+#include "ThroughputSearch.hpp"
+#include "LoopbackRunner.hpp"
+
+namespace riosession {
+
+ThroughputSearch::ThroughputSearch(args_t* args, volatile sig_atomic_t* signal)
+    : m_Args(args), m_ExitSignal(signal) {
+}
+
+void ThroughputSearch::Start() {
+    std::vector<std::pair<uint32_t, uint64_t>> results;
+    for (auto payloadSize : m_Args->SearchSizes) {
+        if (*m_ExitSignal) {
+            break;
+        }
+        results.emplace_back(payloadSize, SearchPayloadSize(payloadSize));
+    }
+    PrintResults(results);
+}
+
+/**
+ * @brief Binary search of the highest passing rate for one payload size.
+ *
+ * @return uint64_t Highest rate that passed, 0 if even --search_min_pps lost packets
+ */
+uint64_t ThroughputSearch::SearchPayloadSize(uint32_t payloadSize) {
+    uint64_t passRate = m_Args->SearchMinPacketRate;
+    uint64_t failRate = m_Args->SearchMaxPacketRate;
+
+    auto trial = RunTrial(failRate, payloadSize);
+    if (trial.Passed) {
+        return trial.Rate;
+    }
+    failRate = trial.Rate;
+    if (passRate >= failRate || *m_ExitSignal) {
+        return 0;
+    }
+    trial = RunTrial(passRate, payloadSize);
+    if (!trial.Passed) {
+        return 0;
+    }
+    passRate = trial.Rate;
+    // Trials run a whole number of pps per stream, so no step is finer than one per stream
+    const uint64_t resolution = std::max(static_cast<uint64_t>(m_Args->SearchResolution),
+                                         static_cast<uint64_t>(m_Args->Streams()));
+    while (failRate - passRate > resolution && !*m_ExitSignal) {
+        trial = RunTrial(passRate + (failRate - passRate) / 2, payloadSize);
+        if (trial.Passed) {
+            passRate = trial.Rate;
+        } else {
+            failRate = trial.Rate;
+        }
+    }
+    return passRate;
+}
+
+/**
+ * @brief Send @p rate packets per second (sum of all streams) for --trial_sec and count what
+ * the consumer got. The rate is rounded down to a whole number of pps per stream, and the
+ * result reports that effective rate.
+ */
+TrialResult_t ThroughputSearch::RunTrial(uint64_t rate, uint32_t payloadSize) {
+    const auto streams = static_cast<uint64_t>(m_Args->Streams());
+    const uint64_t streamRate = std::max<uint64_t>(rate / streams, 1);
+    rate = streamRate * streams;
+    args_t consumerArgs = *m_Args;
+    consumerArgs.PayloadSize = payloadSize;
+    consumerArgs.ExpectedPacketRate = rate;
+    consumerArgs.ChurnRate = CHURN_RATE_OFF;
+
+    args_t producerArgs = *m_Args;
+    producerArgs.PayloadSize = payloadSize;
+    producerArgs.PacketRate = static_cast<int>(streamRate);
+    producerArgs.PktsToCount = 0;
+    producerArgs.SecondsToRun = m_Args->TrialSec;
+    producerArgs.PcapFile.clear();
+    producerArgs.LineRate = false;
+    producerArgs.Profile = PROFILE_CONSTANT;
+    producerArgs.RateFile.clear();
+
+    auto result = LoopbackRunner(m_ExitSignal).Run(producerArgs, consumerArgs);
+    TrialResult_t trial{rate, result.Sent, result.Received.TotalPackets, result.Lost(), false};
+    trial.Passed = trial.Sent > 0 && trial.Dropped == 0 && !*m_ExitSignal;
+    PrintTrial(trial, payloadSize);
+    return trial;
+}
+
+void ThroughputSearch::PrintTrial(const TrialResult_t& trial, uint32_t payloadSize) const {
+    printf("\nTrial %u bytes at %llu pps: sent %llu, received %llu, lost %llu -> %s\n\n",
+           payloadSize, trial.Rate, trial.Sent, trial.Received, trial.Dropped,
+           trial.Passed ? "PASS" : "FAIL");
+}
+
+void ThroughputSearch::PrintResults(
+    const std::vector<std::pair<uint32_t, uint64_t>>& results) const {
+    printf("\n  Payload   Zero loss rate (pps)   Throughput (Mbps)\n");
+    printf("-----------------------------------------------------\n");
+    for (const auto& [payloadSize, rate] : results) {
+        if (rate == 0) {
+            printf("%9u   %20s   %17s\n", payloadSize, "none", "-");
+        } else {
+            printf("%9u   %20llu   %17.1f\n", payloadSize, rate, rate * payloadSize * 8 / 1e6);
+        }
+    }
+    printf("\n");
+}
+
+}  // namespace riosession
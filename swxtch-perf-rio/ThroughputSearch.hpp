@@ -0,0 +1,42 @@
+#pragma once
+// clang-format off
+#include <signal.h>
+#include <stdint.h>
+#include <vector>
+#include "args.hpp"
+// clang-format on
+
+namespace riosession {
+
+struct TrialResult_t {
+    uint64_t Rate;
+    uint64_t Sent;
+    uint64_t Received;
+    uint64_t Dropped;
+    bool Passed;
+};
+
+/**
+ * @brief RFC 2544 style search of the highest zero-loss rate. For each payload size a
+ * consumer and a producer session are run in this process (see LoopbackRunner) for
+ * --trial_sec at each trial rate.
+ * A trial passes when the consumer reports no RxDropped and received every packet sent; the
+ * rate is then binary searched between --search_min_pps and --search_max_pps down to
+ * --search_resolution.
+ */
+class ThroughputSearch {
+   public:
+    ThroughputSearch(args_t* args, volatile sig_atomic_t* signal);
+    void Start();
+
+   private:
+    uint64_t SearchPayloadSize(uint32_t payloadSize);
+    TrialResult_t RunTrial(uint64_t rate, uint32_t payloadSize);
+    void PrintTrial(const TrialResult_t& trial, uint32_t payloadSize) const;
+    void PrintResults(const std::vector<std::pair<uint32_t, uint64_t>>& results) const;
+
+    args_t* m_Args;
+    volatile sig_atomic_t* m_ExitSignal;
+};
+
+}  // namespace riosession
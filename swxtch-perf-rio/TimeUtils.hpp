@@ -0,0 +1,35 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <chrono>
+// clang-format on
+
+namespace utilities {
+
+constexpr uint64_t ONE_SECOND = 1000000000;
+
+inline uint64_t get_unix_time(void) {
+    auto now = std::chrono::system_clock::now();
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
+}
+
+/**
+ * @brief Wait for @spin nanoseconds. Wasting CPU time
+ * 
+ * @param nano 
+ */
+inline void spin(uint64_t nano) {
+    if (nano <= 1000) {
+        return;
+    }
+    auto StartTime(std::chrono::high_resolution_clock::now());
+    while (true) {
+        auto CurrentTime(std::chrono::high_resolution_clock::now());
+        auto ElapsedTime_ns
+            = std::chrono::duration_cast<std::chrono::nanoseconds>(CurrentTime - StartTime).count();
+        if (ElapsedTime_ns >= nano)
+            break;
+    }
+}
+
+}  // namespace utilities
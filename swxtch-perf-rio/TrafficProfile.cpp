@@ -0,0 +1,206 @@
+#include "TrafficProfile.hpp"
+// clang-format off
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+// clang-format on
+
+namespace riosession {
+
+namespace {
+constexpr uint64_t NS_PER_SEC = 1000000000ULL;
+constexpr uint64_t NS_PER_MS = 1000000ULL;
+constexpr uint64_t CYCLE_NS = NS_PER_SEC;
+constexpr uint64_t POISSON_SEED = 0x5357585443480001ULL;  // Same schedule on every run
+}  // namespace
+
+TrafficProfile::TrafficProfile(const args_t* args) : m_Name(args->Profile) {
+    m_Rates.assign(args->McastAddrStr.size(), static_cast<double>(args->PacketRate));
+    if (!args->RateFile.empty()) {
+        LoadRateFile(args);
+    }
+    // Each port of a group is a stream at the group's rate, streams are group major
+    const size_t ports = args->McastPorts.size();
+    if (ports > 1) {
+        std::vector<double> streamRates;
+        for (auto rate : m_Rates) {
+            streamRates.insert(streamRates.end(), ports, rate);
+        }
+        m_Rates = std::move(streamRates);
+    }
+    double totalRate = 0;
+    for (auto rate : m_Rates) {
+        totalRate += rate;
+    }
+    if (totalRate <= 0) {
+        throw std::runtime_error("Traffic profile: every group has a rate of 0");
+    }
+    // The peak is the highest rate of the profile, the end of a ramp
+    const double peakRate = m_Name == PROFILE_RAMP
+                                ? totalRate * args->RampToPacketRate / args->PacketRate
+                                : totalRate;
+    if (peakRate > MAX_PACKET_RATE) {
+        throw std::runtime_error("Traffic profile: peaks at "
+                                 + std::to_string(static_cast<int64_t>(peakRate))
+                                 + " pps, more than the 1M pps limit");
+    }
+
+    std::vector<Timed_t> timed;
+    if (m_Name == PROFILE_CONSTANT) {
+        m_PeriodNs = CYCLE_NS;
+        CheckSize(totalRate);
+        AddPaced(timed, 0, m_PeriodNs, 1.0);
+    } else if (m_Name == PROFILE_BURST) {
+        const uint64_t onNs = args->BurstOnMs * NS_PER_MS;
+        m_PeriodNs = onNs + args->BurstOffMs * NS_PER_MS;
+        CheckSize(totalRate * onNs / NS_PER_SEC);
+        AddPaced(timed, 0, onNs, 1.0);
+    } else if (m_Name == PROFILE_POISSON) {
+        m_PeriodNs = CYCLE_NS;
+        CheckSize(totalRate);
+        AddPoisson(timed, m_PeriodNs);
+    } else if (m_Name == PROFILE_RAMP) {
+        const uint64_t rampNs = args->RampSec * NS_PER_SEC;
+        const double toScale = static_cast<double>(args->RampToPacketRate) / args->PacketRate;
+        // Average rate over the ramp, then one cycle at the final rate
+        CheckSize(totalRate * (1.0 + toScale) / 2.0 * args->RampSec + totalRate * toScale);
+        AddRamp(timed, rampNs, toScale);
+        Append(timed);
+        m_LoopFrom = m_Departures.size();
+        m_CycleStart = rampNs;
+        m_PeriodNs = CYCLE_NS;
+        timed.clear();
+        AddPaced(timed, 0, m_PeriodNs, toScale);
+    } else {
+        throw std::runtime_error("Unknown traffic profile: " + m_Name);
+    }
+    Append(timed);
+    if (m_Departures.size() == m_LoopFrom) {
+        throw std::runtime_error("Traffic profile: the rates are too low to send in a cycle");
+    }
+}
+
+/**
+ * @brief Override the rate of some groups. One "<group address> <pps>" per line, '#' starts a
+ * comment. Groups that are not listed keep --pps.
+ */
+void TrafficProfile::LoadRateFile(const args_t* args) {
+    std::ifstream file(args->RateFile);
+    if (!file) {
+        throw std::runtime_error("Cannot open rate file " + args->RateFile);
+    }
+    std::string line;
+    for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream fields(line);
+        std::string group;
+        double rate;
+        if (!(fields >> group)) {
+            continue;
+        }
+        if (!(fields >> rate) || rate < 0) {
+            throw std::runtime_error(args->RateFile + ":" + std::to_string(lineNumber)
+                                     + ": expected \"<group address> <pps>\"");
+        }
+        auto it = std::find_if(args->McastAddrStr.begin(), args->McastAddrStr.end(),
+                               [&group](const auto& addr) { return addr.str() == group; });
+        if (it == args->McastAddrStr.end()) {
+            throw std::runtime_error(args->RateFile + ":" + std::to_string(lineNumber) + ": "
+                                     + group + " is not one of the --mcast_ip groups");
+        }
+        m_Rates[it - args->McastAddrStr.begin()] = rate;
+    }
+}
+
+void TrafficProfile::CheckSize(double departures) const {
+    if (departures > MAX_SCHEDULE_DEPARTURES) {
+        throw std::runtime_error("Traffic profile: more than "
+                                 + std::to_string(MAX_SCHEDULE_DEPARTURES)
+                                 + " departures to precompute, lower the rates or the duration");
+    }
+}
+
+/**
+ * @brief Evenly paced departures of every group over [fromNs, toNs), at its rate times
+ * @p scale. Groups are phase shifted so they do not all depart at the same instant.
+ */
+void TrafficProfile::AddPaced(std::vector<Timed_t>& timed,
+                              uint64_t fromNs,
+                              uint64_t toNs,
+                              double scale) const {
+    const uint32_t groups = static_cast<uint32_t>(m_Rates.size());
+    for (uint32_t g = 0; g < groups; g++) {
+        const double rate = m_Rates[g] * scale;
+        const auto count = std::llround(rate * (toNs - fromNs) / NS_PER_SEC);
+        if (count <= 0) {
+            continue;
+        }
+        const double gapNs = static_cast<double>(toNs - fromNs) / count;
+        const double phaseNs = gapNs * g / groups;
+        for (long long k = 0; k < count; k++) {
+            timed.emplace_back(fromNs + static_cast<uint64_t>(phaseNs + k * gapNs), g);
+        }
+    }
+}
+
+/**
+ * @brief Poisson arrivals of every group over [0, toNs): exponential gaps with a mean of
+ * 1 / rate, from a fixed seed.
+ */
+void TrafficProfile::AddPoisson(std::vector<Timed_t>& timed, uint64_t toNs) const {
+    std::mt19937_64 generator(POISSON_SEED);
+    for (uint32_t g = 0; g < m_Rates.size(); g++) {
+        if (m_Rates[g] <= 0) {
+            continue;
+        }
+        std::exponential_distribution<double> gapSec(m_Rates[g]);
+        for (double t = gapSec(generator) * NS_PER_SEC; t < toNs;
+             t += gapSec(generator) * NS_PER_SEC) {
+            timed.emplace_back(static_cast<uint64_t>(t), g);
+        }
+    }
+}
+
+/**
+ * @brief Departures of every group over [0, toNs) while its rate moves linearly from its
+ * rate to its rate times @p toScale.
+ */
+void TrafficProfile::AddRamp(std::vector<Timed_t>& timed, uint64_t toNs, double toScale) const {
+    for (uint32_t g = 0; g < m_Rates.size(); g++) {
+        const double fromRate = m_Rates[g];
+        const double slope = (fromRate * toScale - fromRate) / toNs;  // pps per ns
+        double t = 0;
+        while (t < toNs) {
+            const double rate = fromRate + slope * t;
+            if (rate <= 0) {
+                // Silent until the ramp brings the rate up
+                t = (slope > 0) ? t + NS_PER_MS : toNs;
+                continue;
+            }
+            timed.emplace_back(static_cast<uint64_t>(t), g);
+            t += NS_PER_SEC / rate;
+        }
+    }
+}
+
+/**
+ * @brief Sort a segment starting at 0 and append it to the schedule as gaps.
+ */
+void TrafficProfile::Append(std::vector<Timed_t>& timed) {
+    std::sort(timed.begin(), timed.end());
+    m_Departures.reserve(m_Departures.size() + timed.size());
+    uint64_t previous = 0;
+    for (const auto& [offsetNs, group] : timed) {
+        if (offsetNs - previous > UINT32_MAX) {
+            throw std::runtime_error(
+                "Traffic profile: rates below 1 packet per 4s are not supported");
+        }
+        m_Departures.push_back({static_cast<uint32_t>(offsetNs - previous), group});
+        previous = offsetNs;
+    }
+}
+
+}  // namespace riosession
@@ -0,0 +1,93 @@
+#pragma once
+// clang-format off
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include "args.hpp"
+// clang-format on
+
+namespace riosession {
+
+constexpr size_t MAX_SCHEDULE_DEPARTURES = 32 * 1024 * 1024;  // 256 MB of schedule
+
+/**
+ * @brief One precomputed departure: the gap since the previous departure and the stream index
+ * (group index times the number of ports plus port index).
+ */
+struct Departure_t {
+    uint32_t GapNs;
+    uint32_t Group;
+};
+
+/**
+ * @brief Precomputed departure schedule of the producer, built from --profile and the per
+ * group rates (--pps, overridden by --rate_file).
+ *
+ * The schedule is made of an optional prologue played once (the ramp) followed by a cycle
+ * of PeriodNs that is looped until the run ends:
+ *  - constant: every group evenly paced at its rate, 1s cycle.
+ *  - burst: groups paced at their rate for --burst_on_ms, then silent for --burst_off_ms.
+ *  - poisson: exponential inter-departures with the mean of each group's rate, 1s cycle.
+ *  - ramp: rates ramp linearly up to --ramp_to_pps / --pps times over --ramp_sec, then the
+ *    final rates are held as a constant cycle.
+ * Building the schedule sorts the departures of all groups once, so the send loop only adds
+ * gaps and never draws random numbers nor computes rates.
+ */
+class TrafficProfile {
+   public:
+    TrafficProfile(const args_t* args);
+
+    /**
+     * @brief Offset from the start of the run at which the next departure is due, and its
+     * stream. Loops over the cycle forever.
+     */
+    uint64_t Next(uint32_t& group) {
+        if (m_Index == m_LoopFrom) {
+            m_Due = m_CycleStart;
+            m_CycleStart += m_PeriodNs;
+        }
+        const auto& departure = m_Departures[m_Index];
+        m_Due += departure.GapNs;
+        group = departure.Group;
+        if (++m_Index == m_Departures.size()) {
+            m_Index = m_LoopFrom;
+        }
+        return m_Due;
+    }
+
+    const std::string& Name() const {
+        return m_Name;
+    }
+    const std::vector<double>& Rates() const {
+        return m_Rates;
+    }
+    size_t NumberOfDepartures() const {
+        return m_Departures.size();
+    }
+    uint64_t PeriodNs() const {
+        return m_PeriodNs;
+    }
+
+   private:
+    using Timed_t = std::pair<uint64_t, uint32_t>;
+
+    void LoadRateFile(const args_t* args);
+    void CheckSize(double departures) const;
+    void AddPaced(std::vector<Timed_t>& timed, uint64_t fromNs, uint64_t toNs, double scale) const;
+    void AddPoisson(std::vector<Timed_t>& timed, uint64_t toNs) const;
+    void AddRamp(std::vector<Timed_t>& timed, uint64_t toNs, double toScale) const;
+    void Append(std::vector<Timed_t>& timed);
+
+    std::string m_Name;
+    std::vector<double> m_Rates;
+    std::vector<Departure_t> m_Departures;
+    size_t m_LoopFrom = 0;
+    uint64_t m_PeriodNs = 0;
+    // Cursor
+    size_t m_Index = 0;
+    uint64_t m_Due = 0;
+    uint64_t m_CycleStart = 0;
+};
+
+}  // namespace riosession
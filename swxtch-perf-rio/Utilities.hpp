@@ -11,6 +11,7 @@
 #include <Windows.h>
 #include <Msi.h>
 #include <chrono>
+#include "TimeUtils.hpp"
 // clang-format on
 
 #pragma comment(lib, "iphlpapi")
@@ -19,8 +20,6 @@
 
 namespace utilities {
 
-constexpr uint64_t ONE_SECOND = 1000000000;
-
 inline bool nicIsNumber(const std::string& nicString) {
     for (char const& c : nicString) {
         if (std::isdigit(c) == 0)
@@ -29,37 +28,20 @@ inline bool nicIsNumber(const std::string& nicString) {
     return true;
 }
 
-inline uint64_t get_unix_time(void) {
-    auto now = std::chrono::system_clock::now();
-    return std::chrono::duration_cast<std::chrono::nanoseconds>(now.time_since_epoch()).count();
-}
-
-/**
- * @brief Wait for @spin nanoseconds. Wasting CPU time
- * 
- * @param nano 
- */
-inline void spin(uint64_t nano) {
-    if (nano <= 1000) {
-        return;
-    }
-    auto StartTime(std::chrono::high_resolution_clock::now());
-    while (true) {
-        auto CurrentTime(std::chrono::high_resolution_clock::now());
-        auto ElapsedTime_ns
-            = std::chrono::duration_cast<std::chrono::nanoseconds>(CurrentTime - StartTime).count();
-        if (ElapsedTime_ns >= nano)
-            break;
-    }
-}
-
 // TODO: wstring_convert and codecvt are deprecated in C++17.
 inline std::string wstr_to_str(const std::wstring& wstr) {
     std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> convert;
     return convert.to_bytes(wstr);
 }
 
-inline uint8_t LocateAdapterWithIfName(std::string ifNameToFind) {
+/**
+ * @brief Find the adapter by index or friendly name and return its IfIndex.
+ *
+ * @param ifNameToFind
+ * @param adapterName If not null, receives the adapter GUID name ("{...}")
+ */
+inline uint8_t LocateAdapterWithIfName(std::string ifNameToFind,
+                                       std::string* adapterName = nullptr) {
     uint8_t ifIndex = 0;
 
     // Set the flags to pass to GetAdaptersAddresses
@@ -112,6 +94,9 @@ inline uint8_t LocateAdapterWithIfName(std::string ifNameToFind) {
         if (fName == ifNameToFind) {
             findFlag = true;
             ifIndex = pCurrAddresses->IfIndex;
+            if (adapterName) {
+                *adapterName = pCurrAddresses->AdapterName;
+            }
             break;
         }
         pCurrAddresses = pCurrAddresses->Next;
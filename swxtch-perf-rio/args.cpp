@@ -1,10 +1,12 @@
 // clang-format off
 #include "args.hpp"
 
+#include <ctype.h>
 #include <errno.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <filesystem>
@@ -21,6 +23,19 @@ void OptionParser::errorMessage(const string& message) const {
     std::cout << "Error: " << message << std::endl;
 }
 
+static std::vector<uint32_t> ParseSizes(const std::string& sizes) {
+    std::vector<uint32_t> sizeVec;
+    for (auto& size : swxtch::str::split(sizes, ',')) {
+        try {
+            sizeVec.push_back(static_cast<uint32_t>(std::stoi(swxtch::str::trim(size))));
+        } catch (const std::invalid_argument&) {
+            std::cout << "Comma separated integers expected for payload sizes";
+            exit(1);
+        }
+    }
+    return sizeVec;
+}
+
 static Ipv4Vect ParseDestinations(const std::string& dest,
                                   const swxtch::net::Ipv4Addr_t& default_ipv4) {
     using namespace swxtch::str;
@@ -36,41 +51,126 @@ static Ipv4Vect ParseDestinations(const std::string& dest,
     return ip_vec;
 }
 
+Ipv4Vect ParseGroups(const std::string& groups) {
+    Ipv4Vect groupVec;
+    for (const auto& group : swxtch::utils::MakeIpv4Range(groups)) {
+        if (group.ipHostOrder() < MIN_MC_IP || group.ipHostOrder() > MAX_MC_IP) {
+            throw std::invalid_argument(group.str() + " is not a multicast group");
+        }
+        if (groupVec.size() == MAX_CONTROL_GROUPS) {
+            throw std::invalid_argument("more than " + std::to_string(MAX_CONTROL_GROUPS)
+                                        + " groups");
+        }
+        groupVec.push_back(group);
+    }
+    return groupVec;
+}
+
+/**
+ * @brief TCP port of a --control socket, CONTROL_PORT_NONE when @p control is not a port
+ *  number (Check tells which channels are valid).
+ */
+static uint16_t ParseControlPort(const std::string& control) {
+    if (control.empty() || control.size() > 5
+        || !std::all_of(control.begin(), control.end(),
+                        [](unsigned char c) { return isdigit(c) != 0; })) {
+        return CONTROL_PORT_NONE;
+    }
+    const int port = std::stoi(control);
+    return port <= 65535 ? static_cast<uint16_t>(port) : CONTROL_PORT_NONE;
+}
+
+/**
+ * @brief Split --aggregator, an IPv4 address with an optional port, into @p args. An empty
+ *  address is AGGREGATOR_OFF for a consumer, which then needs no port, and every address for
+ *  the listeners.
+ */
+static void ParseAggregator(const std::string& aggregator, args_t& args) {
+    const auto colon = aggregator.find(':');
+    args.Aggregator = aggregator.substr(0, colon);
+    args.AggregatorPort = AGGREGATOR_PORT;
+    if (colon == std::string::npos) {
+        return;
+    }
+    if (args.Aggregator.empty() && args.Command == CONSUMER_COMMAND) {
+        std::cout << "Address expected for the aggregator a consumer pushes to, e.g. 10.0.0.4:7500";
+        exit(1);
+    }
+    try {
+        const int port = std::stoi(aggregator.substr(colon + 1));
+        if (port < 1 || port > 65535) {
+            throw std::out_of_range(aggregator);
+        }
+        args.AggregatorPort = static_cast<uint16_t>(port);
+    } catch (const std::exception&) {
+        std::cout << "Address and port expected for the aggregator, e.g. 10.0.0.4:7500";
+        exit(1);
+    }
+}
+
+static std::vector<uint16_t> ParsePorts(const std::string& ports) {
+    std::vector<uint16_t> portVec;
+    try {
+        for (auto port : swxtch::utils::MakePortRange(ports)) {
+            portVec.push_back(port);
+            if (portVec.size() > MAX_PORTS) {
+                break;  // Rejected by Check
+            }
+        }
+    } catch (const std::exception&) {
+        std::cout << "Port or range of ports expected for multicast port";
+        exit(1);
+    }
+    return portVec;
+}
+
 args_t OptionParser::ParseArguments() const {
     args_t args;
     argparse::ArgumentParser Parser(m_argv[0], m_version);
-    Parser.add_argument("command").help("[producer|consumer] produce/consume multicast packets");
+    Parser.add_argument("command").help(
+        "[producer|consumer|search|selftest|mock|churn|control|aggregate|reflector] "
+        "produce/consume multicast packets, search the highest zero-loss rate, self-test with "
+        "both in this process, run the consumer processing over in-memory traffic, time group "
+        "joins and leaves with both in this process, send requests to the --control port of a "
+        "running session, merge the statistics consumers push to --aggregator or consume and "
+        "send every datagram back to its sender");
     Parser.add_argument("--nic")
         .default_value(string(DEFAULT_IFINDEX))
         .help("IfIndex or Name of NIC to use");
     Parser.add_argument("--mcast_ip")
         .default_value(string(MULTICAST_IP))
-        .help("multicast group IP or range of groups IPs.");
+        .help("multicast group IP or range of groups IPs. With --unicast, the destination "
+              "addresses instead: those of the consumer host");
     Parser.add_argument("--mcast_port")
-        .default_value(MULTICAST_PORT)
-        .help("multicast port")
+        .default_value(string(MULTICAST_PORT))
+        .help("multicast port or range of ports, e.g. 10000-10007. Every group is sent to each "
+              "port and the consumer binds a socket per port");
+    Parser.add_argument("--total_pkts")
+        .default_value(MAX_PKTS_TO_RECEIVE)
+        .help("Total packets to send/receive. Insert 0 to not count")
         .action([](const string& value) {
             try {
                 return std::stoi(value);
             } catch (const std::invalid_argument&) {
-                std::cout << "Integer expected for port number";
+                std::cout << "Expected a valid packet number to receive";
                 exit(1);
             }
         });
-    Parser.add_argument("--total_pkts")
-        .default_value(MAX_PKTS_TO_RECEIVE)
-        .help("Total packets to send/receive. Insert 0 to not count")
+    Parser.add_argument("--groups_per_socket")
+        .default_value(GROUPS_PER_SOCKET)
+        .help("(consumer command only) most groups joined by one socket. Larger group ranges are "
+              "spread over more sockets, each with its share of the receive ring")
         .action([](const string& value) {
             try {
                 return std::stoi(value);
             } catch (const std::invalid_argument&) {
-                std::cout << "Expected a valid packet number to receive";
+                std::cout << "Integer expected for groups per socket";
                 exit(1);
             }
         });
     Parser.add_argument("--pps")
         .default_value(PACKET_RATE_SEC)
-        .help("(producer command only) packet-rate or packet per seconds")
+        .help("(producer command only) packets per second of each group and port")
         .action([](const string& value) {
             try {
                 return std::stoi(value);
@@ -90,6 +190,311 @@ args_t OptionParser::ParseArguments() const {
                 exit(1);
             }
         });
+    Parser.add_argument("--pcap")
+        .default_value(string(""))
+        .help("(producer command only) pcap/pcapng file to replay instead of synthetic traffic");
+    Parser.add_argument("--replay_speed")
+        .default_value(REPLAY_SPEED)
+        .help("(producer command only) replay speed factor. 1 is original timing, 0 is as fast "
+              "as possible")
+        .action([](const string& value) {
+            try {
+                return std::stod(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Expected a valid replay speed factor";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--rewrite_hdr")
+        .default_value(false)
+        .implicit_value(true)
+        .help("(producer command only) overwrite Seq and Timestamp of replayed packets");
+    Parser.add_argument("--line_rate")
+        .default_value(false)
+        .implicit_value(true)
+        .help("(producer command only) send as fast as the NIC takes packets, ignoring --pps");
+    Parser.add_argument("--profile")
+        .default_value(string(PROFILE_CONSTANT))
+        .help("(producer command only) traffic profile: constant, burst, poisson or ramp");
+    Parser.add_argument("--burst_on_ms")
+        .default_value(BURST_ON_MS)
+        .help("(producer command only) burst profile: milliseconds sending at --pps")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for burst on time";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--burst_off_ms")
+        .default_value(BURST_OFF_MS)
+        .help("(producer command only) burst profile: milliseconds silent between bursts")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for burst off time";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--ramp_to_pps")
+        .default_value(0)
+        .help("(producer command only) ramp profile: --pps reached at the end of the ramp")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for ramp target rate";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--ramp_sec")
+        .default_value(RAMP_SEC)
+        .help("(producer command only) ramp profile: duration of the ramp in seconds")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for ramp duration";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--rate_file")
+        .default_value(string(""))
+        .help("(producer command only) per group rates, one \"<group address> <pps>\" per line. "
+              "Groups not listed send at --pps");
+    Parser.add_argument("--payload_size")
+        .default_value(PAYLOAD_SIZE)
+        .help("UDP payload size of the synthetic traffic")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for payload size";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--search_sizes")
+        .default_value(string(SEARCH_SIZES))
+        .help("(search command only) comma separated payload sizes to search");
+    Parser.add_argument("--search_min_pps")
+        .default_value(SEARCH_MIN_PPS)
+        .help("(search command and producer --adapt_rate) lowest rate tried, sum of all groups")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for search lowest rate";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--search_max_pps")
+        .default_value(SEARCH_MAX_PPS)
+        .help("(search command and producer --adapt_rate) highest rate tried, sum of all "
+              "groups")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for search highest rate";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--search_resolution")
+        .default_value(SEARCH_RESOLUTION_PPS)
+        .help("(search command only) the search stops when the pass and fail rates are this close")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for search resolution";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--trial_sec")
+        .default_value(TRIAL_SEC)
+        .help("(search command only) seconds each trial rate is sent")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for trial duration";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--latency")
+        .default_value(false)
+        .implicit_value(true)
+        .help("(consumer command only) measure the one way latency from the producer Timestamp. "
+              "The producer and consumer clocks must be synchronized");
+    Parser.add_argument("--busy_poll")
+        .default_value(false)
+        .implicit_value(true)
+        .help("(consumer command only) poll the completion queue instead of waiting for its "
+              "notification. Spends the whole core for the lowest latency. The reflector always "
+              "polls");
+    Parser.add_argument("--stage_report")
+        .default_value(false)
+        .implicit_value(true)
+        .help("print the cycles per stage of the hot loop every report period, not only at the "
+              "end. Needs a build configured with RIO_STAGE_PROBES=ON");
+    Parser.add_argument("--report_ms")
+        .default_value(REPORT_MS_AUTO)
+        .help("milliseconds between the periodic reports, at least 10. 0 reports every 4s "
+              "(consumer) or 1s (producer)")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for report period";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--report_csv")
+        .default_value(string(""))
+        .help("also write every periodic report to this CSV file");
+    Parser.add_argument("--loss_pct")
+        .default_value(0.0)
+        .help("(mock command only) percentage of the synthetic packets lost")
+        .action([](const string& value) {
+            try {
+                return std::stod(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Expected a valid loss percentage";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--reorder_pct")
+        .default_value(0.0)
+        .help("(mock command only) percentage of the synthetic packets delivered out of order")
+        .action([](const string& value) {
+            try {
+                return std::stod(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Expected a valid reorder percentage";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--numa_node")
+        .default_value(NUMA_NODE_AUTO)
+        .help("NUMA node for packet buffers and hot threads. -1 uses the node of the NIC")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for NUMA node";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--large_pages")
+        .default_value(false)
+        .implicit_value(true)
+        .help("allocate the registered packet buffers on large pages when available");
+    Parser.add_argument("--recv_ring")
+        .default_value(RECV_RING_AUTO)
+        .help("(consumer command only) number of preposted receives. 0 sizes it from "
+              "--expected_pps and --burst_ms")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for receive ring size";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--expected_pps")
+        .default_value(EXPECTED_PACKET_RATE)
+        .help("(consumer command only) expected packets per second, sum of all groups. 0 if "
+              "unknown, which preposts the maximum number of receives")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for expected packet rate";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--burst_ms")
+        .default_value(BURST_ABSORPTION_MS)
+        .help("(consumer command only) milliseconds of traffic at --expected_pps the receive "
+              "ring must absorb while the consumer is not draining it")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for burst absorption";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--control")
+        .default_value(string(CONTROL_OFF))
+        .help("(consumer and producer commands) take live requests, e.g. joining groups, from "
+              "this channel: stdin reads them from the console, one per line, and a port number "
+              "listens on that TCP port of 127.0.0.1. The control command sends its console "
+              "lines to that port");
+    Parser.add_argument("--aggregator")
+        .default_value(string(AGGREGATOR_OFF))
+        .help("(consumer, aggregate and producer --adapt_rate) address[:port] of the stats "
+              "aggregator, port 7500 by default: consumers push the counters of every stream "
+              "there each report period, the aggregate command or the adapting producer listens "
+              "on it (every address when empty)");
+    Parser.add_argument("--adapt_rate")
+        .default_value(false)
+        .implicit_value(true)
+        .help("(producer command only) search the highest rate every consumer pushing reports "
+              "to --aggregator receives within --adapt_loss_pct, between --search_min_pps and "
+              "--search_max_pps, and follow it. --pps is ignored, the report period is 250 ms "
+              "unless --report_ms");
+    Parser.add_argument("--adapt_loss_pct")
+        .default_value(ADAPT_LOSS_PCT)
+        .help("(producer command only) highest loss percentage of any consumer at an adapted "
+              "rate")
+        .action([](const string& value) {
+            try {
+                return std::stod(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Expected a valid loss percentage for the rate adaptation";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--rtt")
+        .default_value(false)
+        .implicit_value(true)
+        .help("(producer and selftest commands) receive the echoes of a reflector and measure "
+              "the round trip time of every stream from its Timestamp. Needs a --payload_size "
+              "of at least 28. The selftest command runs a reflector instead of a consumer");
+    Parser.add_argument("--unicast")
+        .default_value(false)
+        .implicit_value(true)
+        .help("send and receive unicast datagrams to the --mcast_ip addresses, with the same "
+              "registered buffers, statistics and reports. The consumer receives on every "
+              "local address and joins nothing");
+    Parser.add_argument("--churn_rate")
+        .default_value(CHURN_RATE_OFF)
+        .help("(consumer and churn commands) join and leave operations per second on the "
+              "churned groups, timing each join and the first packet after it. 0 disables the "
+              "churn (the churn command then uses 20)")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for churn rate";
+                exit(1);
+            }
+        });
+    Parser.add_argument("--churn_groups")
+        .default_value(CHURN_GROUPS_AUTO)
+        .help("(consumer and churn commands) number of groups, the last ones of --mcast_ip, "
+              "joined and left while the others receive. 0 churns the second half")
+        .action([](const string& value) {
+            try {
+                return std::stoi(value);
+            } catch (const std::invalid_argument&) {
+                std::cout << "Integer expected for churned groups";
+                exit(1);
+            }
+        });
     try {
         Parser.parse_args(m_argc, m_argv);
     } catch (const std::runtime_error& err) {
@@ -102,10 +507,50 @@ args_t OptionParser::ParseArguments() const {
     args.IfIndex = Parser.get<>("--nic").c_str();
     args.McastAddrStr
         = ParseDestinations(Parser.get<>("--mcast_ip"), swxtch::net::Ipv4Addr_t{"239.5.69.2"});
-    args.McastPort = (uint16_t)Parser.get<int>("--mcast_port");
+    args.McastPorts = ParsePorts(Parser.get<>("--mcast_port"));
+    args.McastPort = args.McastPorts.front();
+    args.GroupsPerSocket = (uint32_t)Parser.get<int>("--groups_per_socket");
     args.PktsToCount = (uint32_t)Parser.get<int>("--total_pkts");
     args.PacketRate = Parser.get<int>("--pps");
     args.SecondsToRun = Parser.get<int>("--seconds");
+    args.PcapFile = Parser.get<>("--pcap").c_str();
+    args.ReplaySpeed = Parser.get<double>("--replay_speed");
+    args.RewriteHeader = Parser.get<bool>("--rewrite_hdr");
+    args.NumaNode = Parser.get<int>("--numa_node");
+    args.LargePages = Parser.get<bool>("--large_pages");
+    args.RecvRing = (uint32_t)Parser.get<int>("--recv_ring");
+    args.ExpectedPacketRate = (uint64_t)Parser.get<int>("--expected_pps");
+    args.BurstMs = Parser.get<int>("--burst_ms");
+    args.LineRate = Parser.get<bool>("--line_rate");
+    args.Profile = Parser.get<>("--profile").c_str();
+    args.BurstOnMs = Parser.get<int>("--burst_on_ms");
+    args.BurstOffMs = Parser.get<int>("--burst_off_ms");
+    args.RampToPacketRate = Parser.get<int>("--ramp_to_pps");
+    args.RampSec = Parser.get<int>("--ramp_sec");
+    args.RateFile = Parser.get<>("--rate_file").c_str();
+    args.PayloadSize = Parser.get<int>("--payload_size");
+    args.SearchSizes = ParseSizes(Parser.get<>("--search_sizes"));
+    args.SearchMinPacketRate = Parser.get<int>("--search_min_pps");
+    args.SearchMaxPacketRate = Parser.get<int>("--search_max_pps");
+    args.SearchResolution = Parser.get<int>("--search_resolution");
+    args.TrialSec = Parser.get<int>("--trial_sec");
+    args.MeasureLatency = Parser.get<bool>("--latency");
+    args.BusyPoll = Parser.get<bool>("--busy_poll");
+    args.StageReport = Parser.get<bool>("--stage_report");
+    args.LossPct = Parser.get<double>("--loss_pct");
+    args.ReorderPct = Parser.get<double>("--reorder_pct");
+    args.ReportMs = Parser.get<int>("--report_ms");
+    args.ReportCsv = Parser.get<>("--report_csv").c_str();
+    args.Control = Parser.get<>("--control").c_str();
+    args.ControlPort = ParseControlPort(args.Control);
+    ParseAggregator(Parser.get<>("--aggregator").c_str(), args);
+    args.AdaptRate = Parser.get<bool>("--adapt_rate");
+    args.AdaptLossPct = Parser.get<double>("--adapt_loss_pct");
+    args.Rtt = Parser.get<bool>("--rtt");
+    args.Unicast = Parser.get<bool>("--unicast");
+    args.ChurnRate = Parser.get<int>("--churn_rate");
+    args.ChurnGroups = (uint32_t)Parser.get<int>("--churn_groups");
+    args.CoreSlot = 0;
 
     return args;
 }
@@ -147,24 +592,116 @@ bool OptionParser::isValidMulticastIp(const Ipv4Vect& ipVect) const {
     return true;
 }
 
+bool OptionParser::isValidUnicastIp(const Ipv4Vect& ipVect) const {
+    return std::all_of(ipVect.begin(), ipVect.end(), [](const swxtch::net::Ipv4Addr_t& ip) {
+        return MIN_UC_IP <= ip.ipHostOrder() && ip.ipHostOrder() <= MAX_UC_IP;
+    });
+}
+
 bool OptionParser::Check(const args_t* args) const {
     bool sanity_check = false;
     if (args != nullptr) {
         string cmd = args->Command;
-        if (cmd != PRODUCER_COMMAND && cmd != CONSUMER_COMMAND) {
-            errorMessage("Invalid Command. Expected producer or consumer.");
-        } else if (!isValidMulticastIp(args->McastAddrStr)) {
+        auto isValidPayloadSize
+            = [](int size) { return size >= MIN_PAYLOAD_SIZE && size <= MAX_PAYLOAD_SIZE; };
+        if (cmd != PRODUCER_COMMAND && cmd != CONSUMER_COMMAND && cmd != SEARCH_COMMAND
+            && cmd != SELFTEST_COMMAND && cmd != MOCK_COMMAND && cmd != CHURN_COMMAND
+            && cmd != CONTROL_COMMAND && cmd != AGGREGATE_COMMAND && cmd != REFLECTOR_COMMAND) {
+            errorMessage(
+                "Invalid Command. Expected producer, consumer, search, selftest, mock, churn, "
+                "control, aggregate or reflector.");
+        } else if (!args->Unicast && !isValidMulticastIp(args->McastAddrStr)) {
             errorMessage(
                 "Invalid Multicast IP. Expected value between 224.0.0.1 and 239.255.255.255");
+        } else if (args->Unicast && !isValidUnicastIp(args->McastAddrStr)) {
+            errorMessage(
+                "Invalid Unicast IP. Expected host addresses between 1.0.0.0 and "
+                "223.255.255.255");
         } else if (args->IfIndex == "") {
             errorMessage("Invalid IfIndex.");
-        } else if ((args->McastPort > 49151) || (args->McastPort < 1024)) {
-            errorMessage("Invalid Multicast Port. Expected value between 1024 and 49151.");
-        } else if ((args->PacketRate * args->McastAddrStr.size() > 1000000)
+        } else if (args->McastPorts.size() > MAX_PORTS
+                   || std::any_of(args->McastPorts.begin(), args->McastPorts.end(),
+                                  [](uint16_t port) { return port > 49151 || port < 1024; })) {
+            errorMessage(
+                "Invalid Multicast Port. Expected values between 1024 and 49151, at most 64 "
+                "ports.");
+        } else if ((int)args->GroupsPerSocket < 1) {
+            errorMessage("Invalid groups per socket. Expected at least 1.");
+        } else if ((cmd != SEARCH_COMMAND && !args->LineRate
+                    && args->PacketRate * args->Streams() > MAX_PACKET_RATE)
                    || (args->PacketRate < 1)) {
             errorMessage(
                 "Invalid Packet Rate. Expected a value between 0 and 1M. (Sum of all pps per "
-                "group");
+                "group and port");
+        } else if (args->NumaNode < NUMA_NODE_AUTO || args->NumaNode > MAX_NUMA_NODE) {
+            errorMessage("Invalid NUMA node. Expected -1 (auto) or a node number up to 255.");
+        } else if (args->BurstMs < 1) {
+            errorMessage("Invalid burst absorption. Expected at least 1 ms.");
+        } else if (args->ReplaySpeed < 0) {
+            errorMessage("Invalid Replay Speed. Expected a value >= 0.");
+        } else if (args->Profile != PROFILE_CONSTANT && args->Profile != PROFILE_BURST
+                   && args->Profile != PROFILE_POISSON && args->Profile != PROFILE_RAMP) {
+            errorMessage("Invalid Profile. Expected constant, burst, poisson or ramp.");
+        } else if (args->Profile == PROFILE_BURST
+                   && (args->BurstOnMs < 1 || args->BurstOffMs < 0)) {
+            errorMessage("Invalid burst. Expected at least 1 ms on and 0 ms off.");
+        } else if (args->Profile == PROFILE_RAMP
+                   && (args->RampToPacketRate < 1 || args->RampSec < 1)) {
+            errorMessage("Invalid ramp. Expected --ramp_to_pps and --ramp_sec of at least 1.");
+        } else if (args->Profile == PROFILE_RAMP
+                   && args->RampToPacketRate * args->Streams() > MAX_PACKET_RATE) {
+            errorMessage(
+                "Invalid ramp. Expected --ramp_to_pps to end at most at 1M pps. (Sum of all pps "
+                "per group and port)");
+        } else if (args->LineRate
+                   && (args->Profile != PROFILE_CONSTANT || !args->RateFile.empty())) {
+            errorMessage(
+                "Invalid line rate. --line_rate does no pacing, expected it without --profile "
+                "nor --rate_file.");
+        } else if (!isValidPayloadSize(args->PayloadSize)
+                   || args->SearchSizes.empty()
+                   || !std::all_of(args->SearchSizes.begin(), args->SearchSizes.end(),
+                                   isValidPayloadSize)) {
+            errorMessage("Invalid Payload Size. Expected a value between 20 and 65507.");
+        } else if ((cmd == SEARCH_COMMAND || args->AdaptRate)
+                   && (args->SearchMinPacketRate < (int)args->Streams()
+                       || args->SearchMaxPacketRate < args->SearchMinPacketRate
+                       || args->SearchResolution < 1 || args->TrialSec < 1)) {
+            errorMessage(
+                "Invalid search. Expected --search_min_pps of at least one packet per stream, "
+                "--search_max_pps >= --search_min_pps, --search_resolution >= 1 and "
+                "--trial_sec >= 1.");
+        } else if (args->LossPct < 0 || args->LossPct > 100 || args->ReorderPct < 0
+                   || args->ReorderPct > 100) {
+            errorMessage("Invalid mock traffic. Expected percentages between 0 and 100.");
+        } else if (args->ReportMs != REPORT_MS_AUTO && args->ReportMs < MIN_REPORT_MS) {
+            errorMessage("Invalid report period. Expected 0 (default) or at least 10 ms.");
+        } else if (args->Control != CONTROL_OFF && args->Control != CONTROL_STDIN
+                   && args->ControlPort == CONTROL_PORT_NONE) {
+            errorMessage("Invalid control channel. Expected stdin or a TCP port number.");
+        } else if (cmd == CONTROL_COMMAND && args->ControlPort == CONTROL_PORT_NONE) {
+            errorMessage("Invalid control command. Expected the --control port of the session.");
+        } else if (args->AdaptRate
+                   && (cmd != PRODUCER_COMMAND || args->LineRate || !args->PcapFile.empty()
+                       || args->Profile != PROFILE_CONSTANT || !args->RateFile.empty()
+                       || args->AdaptLossPct < 0 || args->AdaptLossPct >= 100)) {
+            errorMessage(
+                "Invalid rate adaptation. Expected the producer at a constant rate, without "
+                "--line_rate, --pcap, --profile nor --rate_file, and --adapt_loss_pct between 0 "
+                "and 100.");
+        } else if (args->Rtt
+                   && ((cmd != PRODUCER_COMMAND && cmd != SELFTEST_COMMAND)
+                       || !args->PcapFile.empty() || args->PayloadSize < MIN_RTT_PAYLOAD_SIZE)) {
+            errorMessage(
+                "Invalid round trip measure. Expected the producer or selftest command with "
+                "synthetic traffic, without --pcap, and a --payload_size of at least 28.");
+        } else if (args->Unicast && (cmd == CHURN_COMMAND || args->ChurnRate != CHURN_RATE_OFF)) {
+            errorMessage("Invalid unicast. Churn joins and leaves groups, unicast has none.");
+        } else if (args->ChurnRate < 0 || (int)args->ChurnGroups < 0
+                   || args->ChurnGroups > args->McastAddrStr.size()) {
+            errorMessage(
+                "Invalid churn. Expected --churn_rate >= 0 and --churn_groups at most the "
+                "number of groups.");
         } else {
             sanity_check = true;
         }
@@ -12,23 +12,123 @@ using Ipv4Vect = std::vector<swxtch::net::Ipv4Addr_t>;
 using args_t = struct args_s {
     std::string Command;
     Ipv4Vect McastAddrStr;
-    uint16_t McastPort;
+    uint16_t McastPort;                // First of McastPorts
+    std::vector<uint16_t> McastPorts;  // Every group is sent to / received on each of them
+    uint32_t GroupsPerSocket;
     std::string IfIndex;
     uint64_t PktsToCount;
     int PacketRate;
     int SecondsToRun;
+    std::string PcapFile;
+    double ReplaySpeed;
+    bool RewriteHeader;
+    int NumaNode;
+    bool LargePages;
+    uint32_t RecvRing;
+    uint64_t ExpectedPacketRate;
+    int BurstMs;
+    bool LineRate;
+    std::string Profile;
+    int BurstOnMs;
+    int BurstOffMs;
+    int RampToPacketRate;
+    int RampSec;
+    std::string RateFile;
+    int PayloadSize;
+    std::vector<uint32_t> SearchSizes;
+    int SearchMinPacketRate;
+    int SearchMaxPacketRate;
+    int SearchResolution;
+    int TrialSec;
+    bool MeasureLatency;
+    bool BusyPoll;
+    bool StageReport;
+    double LossPct;
+    double ReorderPct;
+    int ReportMs;
+    std::string ReportCsv;
+    std::string Control;   // Channel of the live requests, see ControlChannel.hpp
+    uint16_t ControlPort;  // Of a --control socket, CONTROL_PORT_NONE for the other channels
+    std::string Aggregator;   // Address of the stats aggregator, AGGREGATOR_OFF without
+    uint16_t AggregatorPort;  // Its port, see StatsAggregator.hpp
+    bool AdaptRate;       // Producer rate driven by the consumer reports, see RateAdapter.hpp
+    double AdaptLossPct;  // Highest loss of any receiver at an adapted rate
+    bool Rtt;  // Producer round trip times from the echoes of a reflector
+    bool Unicast;  // McastAddrStr holds unicast destinations, nothing is joined
+    int ChurnRate;         // Join and leave operations per second, 0 without churn
+    uint32_t ChurnGroups;  // Groups churned, the last ones of McastAddrStr
+    uint32_t CoreSlot;  // First processor of the NUMA node used by the session threads
+
+    /**
+     * @brief Number of (group, port) streams, each with its own sequence and statistics.
+     */
+    size_t Streams() const {
+        return McastAddrStr.size() * McastPorts.size();
+    }
 };
 
 constexpr char MULTICAST_IP[] = "239.5.69.2";
 constexpr size_t MIN_MC_IP = 0xE0000001;
 constexpr size_t MAX_MC_IP = 0xEFFFFFFF;
+constexpr size_t MIN_UC_IP = 0x01000000;  // Class A to C host addresses
+constexpr size_t MAX_UC_IP = 0xDFFFFFFF;
 constexpr char DEFAULT_IFINDEX[] = "Ethernet";
-constexpr int MULTICAST_PORT = 10000;
+constexpr char MULTICAST_PORT[] = "10000";
+constexpr size_t MAX_PORTS = 64;  // The consumer opens one socket per port and group slice
+constexpr int GROUPS_PER_SOCKET = 256;
 constexpr int MAX_PKTS_TO_RECEIVE = 20000000;
 constexpr char CONSUMER_COMMAND[] = "consumer";
 constexpr char PRODUCER_COMMAND[] = "producer";
+constexpr char SEARCH_COMMAND[] = "search";
+constexpr char SELFTEST_COMMAND[] = "selftest";
+constexpr char MOCK_COMMAND[] = "mock";
+constexpr char CHURN_COMMAND[] = "churn";
+constexpr char CONTROL_COMMAND[] = "control";
+constexpr char AGGREGATE_COMMAND[] = "aggregate";
+constexpr char REFLECTOR_COMMAND[] = "reflector";
 constexpr int PACKET_RATE_SEC = 1;
 constexpr int RUN_FOR_NSEC = 0;
+constexpr double REPLAY_SPEED = 1.0;
+constexpr int NUMA_NODE_AUTO = -1;
+constexpr int MAX_NUMA_NODE = 255;  // Highest node of the node masks, see AllocateOnNode
+constexpr int RECV_RING_AUTO = 0;
+constexpr int EXPECTED_PACKET_RATE = 0;
+constexpr int BURST_ABSORPTION_MS = 100;
+constexpr char PROFILE_CONSTANT[] = "constant";
+constexpr char PROFILE_BURST[] = "burst";
+constexpr char PROFILE_POISSON[] = "poisson";
+constexpr char PROFILE_RAMP[] = "ramp";
+constexpr int BURST_ON_MS = 10;
+constexpr int BURST_OFF_MS = 90;
+constexpr int RAMP_SEC = 10;
+constexpr int PAYLOAD_SIZE = 100;
+constexpr int MIN_PAYLOAD_SIZE = 20;  // Protocol header
+constexpr int MIN_RTT_PAYLOAD_SIZE = 28;  // And the stream stamped for the echoes
+constexpr int MAX_PAYLOAD_SIZE = 65507;
+constexpr char SEARCH_SIZES[] = "100";
+constexpr int SEARCH_MIN_PPS = 1000;
+constexpr int SEARCH_MAX_PPS = 1000000;
+constexpr int64_t MAX_PACKET_RATE = 1000000;  // Sum over the streams, without --line_rate
+constexpr int SEARCH_RESOLUTION_PPS = 1000;
+constexpr int TRIAL_SEC = 10;
+constexpr int REPORT_MS_AUTO = 0;
+constexpr int MIN_REPORT_MS = 10;
+constexpr int CHURN_RATE_OFF = 0;
+constexpr char CONTROL_OFF[] = "";
+constexpr char CONTROL_STDIN[] = "stdin";
+constexpr uint16_t CONTROL_PORT_NONE = 0;
+constexpr char AGGREGATOR_OFF[] = "";  // The aggregate command then listens on every address
+constexpr uint16_t AGGREGATOR_PORT = 7500;
+constexpr double ADAPT_LOSS_PCT = 0.01;
+constexpr size_t MAX_CONTROL_GROUPS = 65536;  // Groups in one live request
+constexpr int CHURN_GROUPS_AUTO = 0;  // The second half of --mcast_ip
+
+/**
+ * @brief Groups of a --mcast_ip style address or range, for the live requests.
+ *  Throws std::invalid_argument when one is not a multicast address, or for more than
+ *  MAX_CONTROL_GROUPS groups.
+ */
+Ipv4Vect ParseGroups(const std::string& groups);
 
 class OptionParser {
    public:
@@ -41,6 +141,7 @@ class OptionParser {
    private:
     void errorMessage(const std::string&) const;
     bool isValidMulticastIp(const Ipv4Vect&) const;
+    bool isValidUnicastIp(const Ipv4Vect&) const;
 
     int m_argc;
     char** m_argv;
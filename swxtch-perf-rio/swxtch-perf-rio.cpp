@@ -1,5 +1,10 @@
 #include "RioConsumer.hpp"
 #include "RioProducer.hpp"
+#include "ThroughputSearch.hpp"
+#include "SelfTest.hpp"
+#include "ChurnTest.hpp"
+#include "MockConsumer.hpp"
+#include "StatsAggregator.hpp"
 #include "auto_gen_ver_info.h"
 
 static volatile sig_atomic_t g_Exit = 0;
@@ -29,10 +34,24 @@ void InitializeWSA() {
     if (0 != ::WSAStartup(wVersionRequested, &data)) {
         utilities::ErrorExit("WSAStartup");
     }
+}
 
-    if (riosession::LARGE_PAGES_ENABLED) {
-        // check that we have SetLockMemoryPrivilege and enable it
-        utilities::ErrorExit("TODO - USE_LARGE_PAGES");
+/**
+ * @brief Enable SeLockMemoryPrivilege when large pages are requested.
+ *  Falls back to regular pages if the privilege is not granted.
+ */
+void InitializeLargePages(args_t* args) {
+    if (!args->LargePages) {
+        return;
+    }
+    if (swxtch::sys::EnableLargePages()) {
+        std::cout << "\tLarge pages of " << swxtch::sys::LargePageSize() / 1024
+                  << " KB enabled" << std::endl;
+    } else {
+        std::cout << "\tLarge pages unavailable (\"Lock pages in memory\" not granted?), "
+                     "using regular pages"
+                  << std::endl;
+        args->LargePages = false;
     }
 }
 
@@ -43,12 +62,36 @@ int main(int argc, char** argv) {
     if (!op.Check(&args)) {
         return 1;
     }
+    if (args.Command == CONTROL_COMMAND) {
+        // A client of another session's control socket: no NIC to locate
+        InitializeWSA();
+        const int exitCode = RunControlClient(args.ControlPort);
+        WSACleanup();
+        return exitCode;
+    }
+    if (args.Command == AGGREGATE_COMMAND) {
+        // Reports only: no NIC to locate
+        InitializeWSA();
+        SetConsoleCtrlHandler(HandlerRoutine, TRUE);
+        StatsAggregator(&args, &g_Exit).Start();
+        WSACleanup();
+        return 0;
+    }
+    if (args.Command == MOCK_COMMAND) {
+        // In-memory traffic only: no NIC, socket nor RIO to set up
+        return MockConsumer(&args).Start() ? 0 : 1;
+    }
 
     try {
         // Check if the index is a valid one, and override the struct string with
         // the actual IP Address (xxx.xxx.xxx.xxx)
-        args.IfIndex = std::to_string(utilities::LocateAdapterWithIfName(args.IfIndex));
+        std::string adapterName;
+        args.IfIndex
+            = std::to_string(utilities::LocateAdapterWithIfName(args.IfIndex, &adapterName));
         args.IfIndex = utilities::GetInterfaceIpAddress(args.IfIndex);
+        if (args.NumaNode == NUMA_NODE_AUTO) {
+            args.NumaNode = swxtch::sys::NicNumaNode(adapterName);
+        }
     } catch (const std::exception& ex) {
         std::cerr << ex.what() << std::endl;
         return -1;
@@ -56,13 +99,22 @@ int main(int argc, char** argv) {
 
     //
     std::cout << "Config: " << std::endl;
-    std::cout << "\tWaiting traffic from " << args.McastAddrStr.size() << " multicast groups"
-              << std::endl;
+    std::cout << "\tWaiting traffic from " << args.McastAddrStr.size()
+              << (args.Unicast ? " unicast addresses" : " multicast groups") << std::endl;
     for (const auto mcAddr : args.McastAddrStr) {
-        std::cout << "\tMcast group: " << mcAddr.str() << std::endl;
+        std::cout << (args.Unicast ? "\tUnicast address: " : "\tMcast group: ") << mcAddr.str()
+                  << std::endl;
+    }
+    std::cout << "\tMCast Port    : " << args.McastPorts.front();
+    if (args.McastPorts.size() > 1) {
+        std::cout << "-" << args.McastPorts.back();
     }
-    std::cout << "\tMCast Port    : " << args.McastPort << std::endl;
+    std::cout << std::endl;
     std::cout << "\tInterface IP Address     : " << args.IfIndex << std::endl;
+    if (args.NumaNode >= 0)
+        std::cout << "\tNUMA node    : " << args.NumaNode << std::endl;
+    else
+        std::cout << "\tNUMA node unknown, buffers and threads are not placed" << std::endl;
     if (args.PktsToCount)
         std::cout << "\tCounting a total of: " << args.PktsToCount << " packets" << std::endl;
     else
@@ -72,17 +124,64 @@ int main(int argc, char** argv) {
                   << std::endl;
     else
         std::cout << "\tRunning the application without a timing limit" << std::endl;
+    if (!args.PcapFile.empty())
+        std::cout << "\tReplaying capture file: " << args.PcapFile << std::endl;
+    if (args.LineRate && args.Command == PRODUCER_COMMAND)
+        std::cout << "\tSending at line rate, --pps is ignored" << std::endl;
+    if (args.ChurnRate != CHURN_RATE_OFF && args.Command == CONSUMER_COMMAND)
+        std::cout << "\tChurning " << GroupChurn::ChurnedGroups(args) << " groups, "
+                  << args.ChurnRate << " joins and leaves per second" << std::endl;
+    if (!args.Aggregator.empty() && args.Command == CONSUMER_COMMAND)
+        std::cout << "\tPushing the statistics to the aggregator at " << args.Aggregator << ":"
+                  << args.AggregatorPort << std::endl;
+    if (args.AdaptRate)
+        std::cout << "\tAdapting the rate to the consumer reports on "
+                  << (args.Aggregator.empty() ? "*" : args.Aggregator) << ":"
+                  << args.AggregatorPort << ", between " << args.SearchMinPacketRate << " and "
+                  << args.SearchMaxPacketRate << " pps, within " << args.AdaptLossPct << "% loss"
+                  << std::endl;
+    if (args.Command == REFLECTOR_COMMAND)
+        std::cout << "\tReflecting every datagram back to its sender" << std::endl;
+    if (args.Rtt)
+        std::cout << "\tMeasuring the round trip from the echoes of a reflector" << std::endl;
+    if (args.ControlPort != CONTROL_PORT_NONE)
+        std::cout << "\tLive requests on " << CONTROL_ADDRESS << ":" << args.ControlPort
+                  << std::endl;
+    else if (args.Control != CONTROL_OFF)
+        std::cout << "\tLive requests from " << args.Control << std::endl;
+    if (args.Command == SEARCH_COMMAND)
+        std::cout << "\tSearching the zero loss rate between " << args.SearchMinPacketRate
+                  << " and " << args.SearchMaxPacketRate << " pps, " << args.TrialSec
+                  << " seconds per trial" << std::endl;
     //
+    InitializeLargePages(&args);
     InitializeWSA();
     SetConsoleCtrlHandler(HandlerRoutine, TRUE);
-    if (args.Command == PRODUCER_COMMAND) {
-        RioProducer rioProducer(&args, &g_Exit);
-        rioProducer.Start();
-        rioProducer.CleanUpRIO();
-    } else {
-        RioConsumer rioConsumer(&args, &g_Exit);
-        rioConsumer.Start();
-        rioConsumer.CleanUpRIO();
+    int exitCode = 0;
+    try {
+        if (args.Command == SEARCH_COMMAND) {
+            ThroughputSearch search(&args, &g_Exit);
+            search.Start();
+        } else if (args.Command == SELFTEST_COMMAND) {
+            SelfTest selfTest(&args, &g_Exit);
+            exitCode = selfTest.Start() ? 0 : 1;
+        } else if (args.Command == CHURN_COMMAND) {
+            ChurnTest churnTest(&args, &g_Exit);
+            exitCode = churnTest.Start() ? 0 : 1;
+        } else if (args.Command == PRODUCER_COMMAND) {
+            RioProducer rioProducer(&args, &g_Exit);
+            rioProducer.Start();
+            rioProducer.CleanUpRIO();
+        } else {
+            RioConsumer rioConsumer(&args, &g_Exit);
+            rioConsumer.Start();
+            rioConsumer.CleanUpRIO();
+        }
+    } catch (const std::exception& ex) {
+        std::cerr << ex.what() << std::endl;
+        WSACleanup();
+        return -1;
     }
     WSACleanup();
+    return exitCode;
 }